@@ -0,0 +1,123 @@
+#include "attacks.h"
+
+#include <random>
+#include <vector>
+
+bool usePext = false;
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+Bitboard betweenTable[64][64];
+Bitboard lineTable[64][64];
+
+// shared attack storage: sum of 2^bits over all squares
+static Bitboard rookTable[0x19000];
+static Bitboard bishopTable[0x1480];
+
+static const int rookDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
+static const int bishopDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+
+// медленная генерация атак по лучам, используется только при инициализации
+static Bitboard slidingAttacks(int sq, Bitboard occ, const int (&dirs)[4][2]) {
+    Bitboard b = 0;
+    for (auto &d : dirs) {
+        int nx = fileOf(sq) + d[0], ny = rankOf(sq) + d[1];
+        while (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
+            Bitboard s = squareBB(makeSquare(nx, ny));
+            b |= s;
+            if (occ & s) break;
+            nx += d[0];
+            ny += d[1];
+        }
+    }
+    return b;
+}
+
+static bool cpuHasBmi2() {
+#if SHINY_HAS_PEXT
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+static void initSlider(Magic* magics, Bitboard* table, const int (&dirs)[4][2], std::mt19937_64& rng) {
+    std::vector<Bitboard> occupancy(4096), reference(4096);
+    std::vector<int> epoch(4096, 0);
+    int attempt = 0;
+    Bitboard* next = table;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Magic& m = magics[sq];
+
+        // крайние клетки луча не влияют на атаки
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * rankOf(sq))))
+                       | ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << fileOf(sq)));
+        m.mask = slidingAttacks(sq, 0, dirs) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = next;
+
+        // перебор всех подмножеств маски (Carry-Rippler)
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(sq, b, dirs);
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        next += size;
+
+#if SHINY_HAS_PEXT
+        if (usePext) {
+            m.magic = 0;
+            for (int i = 0; i < size; ++i) m.attacks[pext(occupancy[i], m.mask)] = reference[i];
+            continue;
+        }
+#endif
+
+        // ищем множитель без разрушительных коллизий
+        for (int i = 0; i < size; ) {
+            do {
+                m.magic = rng() & rng() & rng();
+            } while (popCount((m.magic * m.mask) >> 56) < 6);
+
+            ++attempt;
+            for (i = 0; i < size; ++i) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void initAttacks() {
+    usePext = cpuHasBmi2();
+
+    std::mt19937_64 rng(728); // фиксированный сид: одинаковые magic при каждом запуске
+    initSlider(rookMagics, rookTable, rookDirs, rng);
+    initSlider(bishopMagics, bishopTable, bishopDirs, rng);
+
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            betweenTable[a][b] = 0;
+            lineTable[a][b] = 0;
+            if (a == b) continue;
+            Bitboard ab = squareBB(a) | squareBB(b);
+            if (bishopAttacks(a, 0) & squareBB(b)) {
+                lineTable[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | ab;
+                betweenTable[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            } else if (rookAttacks(a, 0) & squareBB(b)) {
+                lineTable[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | ab;
+                betweenTable[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
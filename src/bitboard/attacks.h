@@ -0,0 +1,130 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <array>
+#include "bitboard.h"
+
+/* PEXT is issued through inline asm so the binary still runs on plain
+   x86-64; whether it is actually used is decided at runtime in initAttacks() */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHINY_HAS_PEXT 1
+#else
+#define SHINY_HAS_PEXT 0
+#endif
+
+namespace attacks_detail {
+
+constexpr Bitboard leaperAttacks(int sq, const int (&deltas)[8][2], int count) {
+    Bitboard b = 0;
+    int x = fileOf(sq), y = rankOf(sq);
+    for (int i = 0; i < count; ++i) {
+        int nx = x + deltas[i][0], ny = y + deltas[i][1];
+        if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) b |= squareBB(makeSquare(nx, ny));
+    }
+    return b;
+}
+
+constexpr int knightDeltas[8][2] = {
+    {1,2},{2,1},{-1,2},{-2,1},
+    {1,-2},{2,-1},{-1,-2},{-2,-1}
+};
+constexpr int kingDeltas[8][2] = {
+    {1,0},{-1,0},{0,1},{0,-1},
+    {1,1},{1,-1},{-1,1},{-1,-1}
+};
+/* [0] black pawn captures, [1] white pawn captures (indexed by the colour bool) */
+constexpr int pawnDeltas[2][8][2] = {
+    {{-1,-1},{1,-1}},
+    {{-1, 1},{1, 1}}
+};
+
+constexpr std::array<Bitboard, 64> makeLeaperTable(const int (&deltas)[8][2], int count) {
+    std::array<Bitboard, 64> t{};
+    for (int sq = 0; sq < 64; ++sq) t[sq] = leaperAttacks(sq, deltas, count);
+    return t;
+}
+
+} // namespace attacks_detail
+
+constexpr std::array<Bitboard, 64> knight_attacks =
+    attacks_detail::makeLeaperTable(attacks_detail::knightDeltas, 8);
+constexpr std::array<Bitboard, 64> king_attacks =
+    attacks_detail::makeLeaperTable(attacks_detail::kingDeltas, 8);
+/* pawn_attacks[color][sq]: squares a pawn of `color` on sq attacks */
+constexpr std::array<std::array<Bitboard, 64>, 2> pawn_attacks = {
+    attacks_detail::makeLeaperTable(attacks_detail::pawnDeltas[0], 2),
+    attacks_detail::makeLeaperTable(attacks_detail::pawnDeltas[1], 2)
+};
+
+extern bool usePext;
+
+#if SHINY_HAS_PEXT
+inline uint64_t pext(uint64_t src, uint64_t mask) {
+    uint64_t res;
+    asm("pextq %2, %1, %0" : "=r"(res) : "r"(src), "r"(mask));
+    return res;
+}
+#endif
+
+/* slider lookup for one square: relevant occupancy mask, multiplier and the
+   slice of the shared attack table it indexes */
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    inline unsigned index(Bitboard occ) const {
+#if SHINY_HAS_PEXT
+        if (usePext) return unsigned(pext(occ, mask));
+#endif
+        return unsigned(((occ & mask) * magic) >> shift);
+    }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+/* [a][b]: squares strictly between a and b / the whole line through them,
+   empty when a and b do not share a rank, file or diagonal */
+extern Bitboard betweenTable[64][64];
+extern Bitboard lineTable[64][64];
+
+/* fills the slider tables, must be called once before any Position is used */
+void initAttacks();
+
+inline Bitboard knightAttacks(int sq) {
+    return knight_attacks[sq];
+}
+
+inline Bitboard kingAttacks(int sq) {
+    return king_attacks[sq];
+}
+
+inline Bitboard pawnAttacks(bool color, int sq) {
+    return pawn_attacks[color][sq];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occ) {
+    const Magic& m = bishopMagics[sq];
+    return m.attacks[m.index(occ)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occ) {
+    const Magic& m = rookMagics[sq];
+    return m.attacks[m.index(occ)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occ) {
+    return bishopAttacks(sq, occ) | rookAttacks(sq, occ);
+}
+
+inline Bitboard betweenBB(int a, int b) {
+    return betweenTable[a][b];
+}
+
+inline Bitboard lineBB(int a, int b) {
+    return lineTable[a][b];
+}
+
+#endif // ATTACKS_H
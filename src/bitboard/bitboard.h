@@ -0,0 +1,80 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <bit>
+#include <cstdint>
+
+/* bit i is square i, square = y * 8 + x, so bit 0 is a1 and bit 63 is h8 */
+using Bitboard = uint64_t;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFULL;
+constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+constexpr inline Bitboard fileBB(int x) {
+    return FILE_A_BB << x;
+}
+
+constexpr inline Bitboard rankBB(int y) {
+    return RANK_1_BB << (8 * y);
+}
+
+/* x = 0, y = 0 is a1 */
+constexpr inline int makeSquare(int x, int y) {
+    return y * 8 + x;
+}
+
+constexpr inline int fileOf(int sq) {
+    return sq & 7;
+}
+
+constexpr inline int rankOf(int sq) {
+    return sq >> 3;
+}
+
+constexpr inline Bitboard squareBB(int sq) {
+    return 1ULL << sq;
+}
+
+constexpr inline int popCount(Bitboard b) {
+    return std::popcount(b);
+}
+
+/* index of the lowest set bit, b must not be empty */
+constexpr inline int lsb(Bitboard b) {
+    return std::countr_zero(b);
+}
+
+/* returns the lowest set bit and clears it */
+constexpr inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+/* one step towards the h-file / a-file, nothing wraps around */
+constexpr inline Bitboard shiftEast(Bitboard b) {
+    return (b & ~FILE_H_BB) << 1;
+}
+
+constexpr inline Bitboard shiftWest(Bitboard b) {
+    return (b & ~FILE_A_BB) >> 1;
+}
+
+/* b and every square above (north) / below (south) it */
+constexpr inline Bitboard northFill(Bitboard b) {
+    b |= b << 8;
+    b |= b << 16;
+    b |= b << 32;
+    return b;
+}
+
+constexpr inline Bitboard southFill(Bitboard b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    b |= b >> 32;
+    return b;
+}
+
+#endif // BITBOARD_H
@@ -1,397 +1,178 @@
 #include "evaluation.h"
+#include "pawns.h"
+#include "psqt.h"
+#include "nnue.h"
+#include "../bitboard/attacks.h"
 #include <array>
-#include <unordered_map>
+#include <atomic>
 #include <algorithm>
 
-/* Helpers */
-using PST = std::array<std::array<int, 8>, 8>;
-
-// pawn
-constexpr PST pawn_table = {{ 
-    {{  0,   0,   0,   0,   0,   0,   0,   0 }},
-    {{  5,  10,  10, -20, -20,  10,  10,   5 }},
-    {{  5,  -5, -10,   0,   0, -10,  -5,   5 }},
-    {{  0,   0,   0,  20,  20,   0,   0,   0 }},
-    {{  5,   5,  10,  25,  25,  10,   5,   5 }},
-    {{ 10,  10,  20,  30,  30,  20,  10,  10 }},
-    {{ 50,  50,  50,  50,  50,  50,  50,  50 }},
-    {{  0,   0,   0,   0,   0,   0,   0,   0 }}
-}}; 
-
-// knight
-constexpr PST knight_table = {{
-    {{-50, -40, -30, -30, -30, -30, -40, -50}},
-    {{-40, -20,   0,   0,   0,   0, -20, -40}},
-    {{-30,   0,  10,  15,  15,  10,   0, -30}},
-    {{-30,   5,  15,  20,  20,  15,   5, -30}},
-    {{-30,   0,  15,  20,  20,  15,   0, -30}},
-    {{-30,   5,  10,  15,  15,  10,   5, -30}},
-    {{-40, -20,   0,   5,   5,   0, -20, -40}},
-    {{-50, -40, -30, -30, -30, -30, -40, -50}}
-}}; 
-
-// bishop
-constexpr PST bishop_table = {{
-    {{-20, -10, -10, -10, -10, -10, -10, -20}},
-    {{-10,   0,   0,   0,   0,   0,   0, -10}},
-    {{-10,   0,  10,  10,  10,  10,   0, -10}},
-    {{-10,   5,   5,  20,  20,   5,   5, -10}},
-    {{-10,   0,  10,  20,  20,  10,   0, -10}},
-    {{-10,  10,  10,  10,  10,  10,  10, -10}},
-    {{-10,   5,   0,   0,   0,   0,   5, -10}},
-    {{-20, -10, -10, -10, -10, -10, -10, -20}}
-}};
-
-// rooks
-constexpr PST rook_table = {{
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
-    {{  5,   5,   5,   10,   10,   5,   5,   5 }},
-    {{  5,   5,   5,   10,   10,   5,   5,   5 }},
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
-    {{  0,   0,   0,   10,   10,   0,   0,   0 }}
-}};
-
-// queen
-constexpr PST queen_table = {{
-    {{-20, -10, -10,  -5,  -5, -10, -10, -20}},
-    {{-10,   0,   0,   0,   0,   0,   0, -10}},
-    {{-10,   0,   5,   5,   5,   5,   0, -10}},
-    {{ -5,   0,   5,   5,   5,   5,   0,  -5}},
-    {{  0,   0,   5,   5,   5,   5,   0,  -5}},
-    {{-10,   5,   5,   5,   5,   5,   0, -10}},
-    {{-10,   0,   5,   0,   0,   0,   0, -10}},
-    {{-20, -10, -10,  -5,  -5, -10, -10, -20}}
-}};
-
-// king (mid game)
-constexpr PST king_mid_table = {{
-    {{-30, -40, -40, -50, -50, -40, -40, -30}},
-    {{-30, -40, -40, -50, -50, -40, -40, -30}},
-    {{-30, -40, -40, -50, -50, -40, -40, -30}},
-    {{-30, -40, -40, -50, -50, -40, -40, -30}},
-    {{-20, -30, -30, -40, -40, -30, -30, -20}},
-    {{-10, -20, -20, -20, -20, -20, -20, -10}},
-    {{ 20,  20,   0,   0,   0,   0,  20,  20}},
-    {{ 20,  30,  10,   0,   0,  10,  30,  20}}
-}};
-
-// king (end game)
-constexpr PST king_end_table = {{
-    {{-50, -40, -30, -20, -20, -30, -40, -50}},
-    {{-30, -20, -101,  0,   0, -10, -20, -30}},
-    {{-30, -10,  20,  30,  30,  20, -10, -30}},
-    {{-30, -10,  30,  40,  40,  30, -10, -30}},
-    {{-30, -10,  30,  40,  40,  30, -10, -30}},
-    {{-30, -10,  20,  30,  30,  20, -10, -30}},
-    {{-30, -30,   0,   0,   0,   0, -30, -30}},
-    {{-50, -30, -30, -30, -30, -30, -30, -50}}
-}};
-
-const std::unordered_map<Figures, PST> pst_map = {
-    {PAWN, pawn_table},
-    {KNIGHT, knight_table},
-    {BISHOP, bishop_table},
-    {ROOK, rook_table},
-    {QUEEN, queen_table}
+/* attack maps of one evaluate() call, built in a single pass over the pieces
+   and shared by king safety, mobility and threats; [color] everywhere */
+struct EvalInfo {
+    Bitboard attackedBy[2][PIECE_IDX_NB]; // by pieces of one type
+    Bitboard attacked[2];                 // by anything of that colour
+    Bitboard attacked2[2];                // by at least two pieces
+    Bitboard kingZone[2];                 // king square and the ring around it
+    int kingAttackers[2];                 // enemy pieces hitting the zone of [color]
+    int kingAttackUnits[2];
+    int mobilityMg[2], mobilityEg[2];
 };
 
-const std::unordered_map<Figures, int> phases_table = {
-    {PAWN, 0},
-    {KNIGHT, 1},
-    {EMPTY, 0},
-    {KING,0},
-    {ROOK, 2},
-    {QUEEN, 4},
-    {BISHOP, 1}
-};
-
-constexpr int phase_max = 24;
-
-/*{
-    white {pawns, doubled pawns, isolated pawns},
-    black {pawns, doubled pawns, isolated pawns}
-}*/
-// возвращает: { white: {pawns, doubled_extra, isolated}, black: {...} }
-std::pair<std::array<int, 3>, std::array<int, 3>>
-count_pawns(const Position& pos) {
-    std::pair<std::array<int, 3>, std::array<int, 3>> res{};
-    auto& [white, black] = res;
-
-    std::array<int, 8> wFiles{}; // количество белых пешек на файле
-    std::array<int, 8> bFiles{}; // количество чёрных пешек на файле
-
-    // pawns
-    for (int file = 0; file < 8; ++file) {
-        for (int rank = 0; rank < 8; ++rank) {
-            Piece p = pos.getPiece(file, rank);
-            if (p.getType() == PAWN) {
-                if (p.isWhite()) {
-                    white[0]++;
-                    wFiles[file]++;
-                } else {
-                    black[0]++;
-                    bFiles[file]++;
-                }
-            }
-        }
+/* mobility is scored around a typical number of safe squares per piece */
+alignas(64) constexpr PieceTable mobility_mg = {0, 4, 5, 2, 1, 0};
+alignas(64) constexpr PieceTable mobility_eg = {0, 4, 5, 4, 2, 0};
+alignas(64) constexpr PieceTable mobility_base = {0, 4, 6, 7, 13, 0};
+/* weight of one piece attacking the enemy king zone */
+alignas(64) constexpr PieceTable king_attack_weight = {0, 2, 2, 3, 5, 0};
+
+constexpr int SHELTER_PENALTY = 25;   // per missing pawn in front of the king
+constexpr int WEAK_RING_PENALTY = 10; // per zone square the enemy hits and we cover at most once
+constexpr int KING_DANGER_MAX = 500;
+constexpr int THREAT_BY_PAWN_MG = 50, THREAT_BY_PAWN_EG = 40;
+constexpr int THREAT_BY_MINOR_MG = 30, THREAT_BY_MINOR_EG = 30;
+constexpr int HANGING_MG = 20, HANGING_EG = 15;
+
+/* cap on the sum of all non-PST terms per phase; the taper of two values
+   within it (with rounding) moves the score by less than LAZY_MARGIN */
+constexpr int POSITIONAL_MAX = LAZY_MARGIN - 1;
+
+static inline Bitboard pieceAttacks(int index, int sq, Bitboard occ) {
+    switch (index) {
+        case KNIGHT_IDX: return knightAttacks(sq);
+        case BISHOP_IDX: return bishopAttacks(sq, occ);
+        case ROOK_IDX:   return rookAttacks(sq, occ);
+        case QUEEN_IDX:  return queenAttacks(sq, occ);
+        default:         return 0;
     }
+}
 
-    // doubled pawns: считаем лишние пешки на файле (count - 1)
-    for (int f = 0; f < 8; ++f) {
-        if (wFiles[f] > 1) white[1] += (wFiles[f] - 1);
-        if (bFiles[f] > 1) black[1] += (bFiles[f] - 1);
-    }
+/* squares attacked by two pawns of `color` at once */
+static inline Bitboard pawnDoubleAttacks(Bitboard pawns, bool color) {
+    Bitboard front = color ? pawns << 8 : pawns >> 8;
+    return shiftEast(front) & shiftWest(front);
+}
 
-    // isolated pawns (количество пешек без соседей)
-    for (int f = 0; f < 8; ++f) {
-        if (wFiles[f] > 0) {
-            bool left = (f > 0) && wFiles[f - 1] > 0;
-            bool right = (f < 7) && wFiles[f + 1] > 0;
-            if (!left && !right) white[2] += wFiles[f];
-        }
-        if (bFiles[f] > 0) {
-            bool left = (f > 0) && bFiles[f - 1] > 0;
-            bool right = (f < 7) && bFiles[f + 1] > 0;
-            if (!left && !right) black[2] += bFiles[f];
-        }
+static void buildEvalInfo(const Position& pos, const PawnEntry& pawns, EvalInfo& ei) {
+    Bitboard occ = pos.occupancy();
+
+    // пешки и король: атаки известны без обхода фигур
+    for (bool color : {WHITE, BLACK}) {
+        int ksq = pos.kingSquare(color);
+        Bitboard king = ksq >= 0 ? kingAttacks(ksq) : 0;
+        ei.kingZone[color] = ksq >= 0 ? king | squareBB(ksq) : 0;
+        ei.attackedBy[color][PAWN_IDX] = pawns.attacks[color];
+        ei.attackedBy[color][KING_IDX] = king;
+        ei.attacked[color] = pawns.attacks[color] | king;
+        ei.attacked2[color] = (pawns.attacks[color] & king)
+                            | pawnDoubleAttacks(pos.pieces(PAWN, color), color);
+        ei.kingAttackers[color] = ei.kingAttackUnits[color] = 0;
+        ei.mobilityMg[color] = ei.mobilityEg[color] = 0;
     }
 
-    return res;
-}
-
-constexpr std::pair<int, int> evaluateKingSafety(const Position& pos, const std::pair<int, int>& wking, const std::pair<int, int>& bking) {
-    std::pair<int, int> res = std::make_pair<int, int>(0, 0);
-    
-    // white
-    {
-        int penalty = 0;
-        // pawn shell
-        int dir = 1;
-        for (int dx = -1; dx <= 1; dx++) {
-            int x = wking.first + dx;
-            int y = wking.second - dir;
-            if (x >= 0 && x < 8 && y >= 0 && y < 8) {
-                Piece p = pos.getPiece(x, y);
-                if (!(p.getType() == PAWN && p.isWhite())) {
-                    penalty += 25;
+    for (bool color : {WHITE, BLACK}) {
+        // safe squares: not our pawns or king, not covered by enemy pawns
+        Bitboard mobilityArea = ~(pos.pieces(PAWN, color) | pos.pieces(KING, color))
+                              & ~ei.attackedBy[!color][PAWN_IDX];
+        Bitboard enemyZone = ei.kingZone[!color];
+
+        for (int i = KNIGHT_IDX; i <= QUEEN_IDX; ++i) {
+            ei.attackedBy[color][i] = 0;
+            Bitboard b = pos.pieces(pieceByIndex[i], color);
+            while (b) {
+                Bitboard att = pieceAttacks(i, popLsb(b), occ);
+                ei.attackedBy[color][i] |= att;
+                ei.attacked2[color] |= ei.attacked[color] & att;
+                ei.attacked[color] |= att;
+
+                int mob = popCount(att & mobilityArea) - mobility_base[i];
+                ei.mobilityMg[color] += mobility_mg[i] * mob;
+                ei.mobilityEg[color] += mobility_eg[i] * mob;
+
+                if (att & enemyZone) {
+                    ei.kingAttackers[!color]++;
+                    ei.kingAttackUnits[!color] += king_attack_weight[i] + popCount(att & enemyZone);
                 }
             }
         }
+    }
+}
 
-        // attack weight
-        const int attackWeight[6] = {0, 2, 2, 3, 4, 0}; 
-        auto mapType = [](Figures f) {
-            switch(f) {
-                case PAWN:   return 0;
-                case KNIGHT: return 1;
-                case BISHOP: return 2;
-                case ROOK:   return 3;
-                case QUEEN:  return 4;
-                case KING:   return 5;
-                default:     return 0;
-            }
-        };
-
-        int attackScore = 0;
-
-        const int dirs[8][2] = {
-            {1,0},{-1,0},{0,1},{0,-1},
-            {1,1},{1,-1},{-1,1},{-1,-1}
-        };
-
-        for (auto &d : dirs) {
-            int nx = wking.first + d[0];
-            int ny = wking.second + d[1];
-            if (nx < 0 || nx >= 8 || ny < 0 || ny >= 8) continue;
-            Piece p = pos.getPiece(nx, ny);
-            if (p.getType() != EMPTY && p.isWhite()) {
-                attackScore += attackWeight[mapType(p.getType())];
-            }
-        }
-
-        // attacked squares around the king
-        for (auto &d : dirs) {
-            int nx = wking.first + d[0];
-            int ny = wking.second + d[1];
-            if (nx < 0 || nx >= 8 || ny < 0 || ny >= 8) continue;
-            if (pos.isSquareAttacked({nx, ny})) {
-                penalty += 10;
-            }
-        }
+/* middlegame king-safety penalty of `color` */
+static int evaluateKingSafety(const Position& pos, const EvalInfo& ei, bool color) {
+    int ksq = pos.kingSquare(color);
+    if (ksq < 0) return 0;
 
-        // transforming attackscore into penalty
-        if (attackScore > 0) {
-            penalty += attackScore * 15;
-        }
+    int penalty = 0;
 
-        res.first = penalty;
+    // pawn shell: the three squares in front of the king
+    int shelterRank = rankOf(ksq) + (color ? 1 : -1);
+    if (shelterRank >= 0 && shelterRank < 8) {
+        Bitboard shell = kingAttacks(ksq) & rankBB(shelterRank);
+        penalty += SHELTER_PENALTY * popCount(shell & ~pos.pieces(PAWN, color));
     }
-    
-    // black
-    {
-        int penalty = 0;
-        // pawn shell
-        int dir = 1;
-        for (int dx = -1; dx <= 1; dx++) {
-            int x = bking.first + dx;
-            int y = bking.second - dir;
-            if (x >= 0 && x < 8 && y >= 0 && y < 8) {
-                Piece p = pos.getPiece(x, y);
-                if (!(p.getType() == PAWN && !p.isWhite())) {
-                    penalty += 25;
-                }
-            }
-        }
-
-        // attack weight
-        const int attackWeight[6] = {0, 2, 2, 3, 4, 0}; 
-        auto mapType = [](Figures f) {
-            switch(f) {
-                case PAWN:   return 0;
-                case KNIGHT: return 1;
-                case BISHOP: return 2;
-                case ROOK:   return 3;
-                case QUEEN:  return 4;
-                case KING:   return 5;
-                default:     return 0;
-            }
-        };
-
-        int attackScore = 0;
-
-        const int dirs[8][2] = {
-            {1,0},{-1,0},{0,1},{0,-1},
-            {1,1},{1,-1},{-1,1},{-1,-1}
-        };
-
-        for (auto &d : dirs) {
-            int nx = bking.first + d[0];
-            int ny = bking.second + d[1];
-            if (nx < 0 || nx >= 8 || ny < 0 || ny >= 8) continue;
-            Piece p = pos.getPiece(nx, ny);
-            if (p.getType() != EMPTY && !p.isWhite()) {
-                attackScore += attackWeight[mapType(p.getType())];
-            }
-        }
-
-        // attacked squares around the king
-        for (auto &d : dirs) {
-            int nx = bking.first + d[0];
-            int ny = bking.second + d[1];
-            if (nx < 0 || nx >= 8 || ny < 0 || ny >= 8) continue;
-            if (pos.isSquareAttacked({nx, ny})) {
-                penalty += 10;
-            }
-        }
 
-        // transforming attackscore into penalty
-        if (attackScore > 0) {
-            penalty += attackScore * 15;
-        }
+    // поля у короля, которые бьёт противник, а мы защищаем не больше одного раза
+    Bitboard weak = ei.kingZone[color] & ei.attacked[!color] & ~ei.attacked2[color];
+    penalty += WEAK_RING_PENALTY * popCount(weak);
 
-        res.second = penalty;
+    // one attacker is rarely dangerous, two or more grow quadratically
+    if (ei.kingAttackers[color] >= 2) {
+        int units = ei.kingAttackUnits[color] + 2 * popCount(weak);
+        penalty += std::min(units * units / 4, KING_DANGER_MAX);
     }
-    
-    return res;
+
+    return penalty;
 }
 
-int evaluate(const Position& pos) {
-    // material values in centipawns
-    const std::unordered_map<Figures, int> pieceValue = {
-        {PAWN, 100},
-        {KNIGHT, 320},
-        {BISHOP, 330},
-        {ROOK, 500},
-        {QUEEN, 900},
-        {KING, 20000}
-    };
-
-    std::pair<int,int> wking = {-1,-1}, bking = {-1,-1};
-    int curphase = 0;
-
-    int materialW = 0, materialB = 0;
-    int pstW = 0, pstB = 0;
-    int pawnPenW = 0, pawnPenB = 0;
-    int kingEvalW = 0, kingEvalB = 0;
-    int kingSafetyW = 0, kingSafetyB = 0;
-
-    // iterate board: file (x) 0..7, rank (y) 0..7
-    for (int file = 0; file < 8; ++file) {
-        for (int rank = 0; rank < 8; ++rank) {
-            Piece piece = pos.getPiece(file, rank);
-            Figures t = piece.getType();
-            if (t == EMPTY) continue;
-
-            if (t == KING) {
-                if (piece.isWhite()) wking = {file, rank};
-                else bking = {file, rank};
-                continue;
-            }
+/* bonus of `color` for attacking enemy pieces: by pawns, majors by minors,
+   and anything the enemy does not defend */
+static void evaluateThreats(const Position& pos, const EvalInfo& ei, bool color, int& mg, int& eg) {
+    bool them = !color;
+    Bitboard pieces = pos.piecesOf(them) & ~pos.pieces(KING, them);
+    Bitboard nonPawns = pieces & ~pos.pieces(PAWN, them);
+    Bitboard majors = pos.pieces(ROOK, them) | pos.pieces(QUEEN, them);
 
-            int base = 0;
-            auto it = pieceValue.find(t);
-            if (it != pieceValue.end()) base = it->second;
-
-            // PST: теперь таблицы трактуются как PST[rank][file]
-            int pstv = 0;
-            auto itpst = pst_map.find(t);
-            if (itpst != pst_map.end()) {
-                if (piece.isWhite()) {
-                    pstv = itpst->second[rank][file];
-                } else {
-                    // для чёрных зеркалим по рангу
-                    pstv = itpst->second[7 - rank][file];
-                }
-            }
+    int byPawn = popCount(nonPawns & ei.attackedBy[color][PAWN_IDX]);
+    int byMinor = popCount(majors & (ei.attackedBy[color][KNIGHT_IDX] | ei.attackedBy[color][BISHOP_IDX]));
+    int hanging = popCount(pieces & ei.attacked[color] & ~ei.attacked[them]);
 
-            if (piece.isWhite()) {
-                materialW += base;
-                pstW += pstv;
-            } else {
-                materialB += base;
-                pstB += pstv;
-            }
+    mg += THREAT_BY_PAWN_MG * byPawn + THREAT_BY_MINOR_MG * byMinor + HANGING_MG * hanging;
+    eg += THREAT_BY_PAWN_EG * byPawn + THREAT_BY_MINOR_EG * byMinor + HANGING_EG * hanging;
+}
 
-            auto itph = phases_table.find(t);
-            if (itph != phases_table.end()) curphase += itph->second;
-        }
-    }
+static int evaluateUncached(const Position& pos) {
+    // голые короли / одна лёгкая фигура: мат невозможен
+    if (pos.isInsufficientMaterial()) return 0;
 
-    // blended king eval
-    int phase = std::min(curphase, phase_max);
-    int mid_weight = phase;
-    int end_weight = phase_max - phase;
+    // pawn structure: one probe of the per-thread pawn hash
+    const PawnEntry& pawns = probePawns(pos);
+    int mg = pawns.mg[WHITE] - pawns.mg[BLACK];
+    int eg = pawns.eg[WHITE] - pawns.eg[BLACK];
 
-    if (wking.first >= 0) {
-        int mid = KING + king_mid_table[wking.second][wking.first];   // note: indexing rank,file if tables defined that way
-        int end = KING + king_end_table[wking.second][wking.first];
-        kingEvalW = (mid * mid_weight + end * end_weight) / phase_max;
-    }
-    if (bking.first >= 0) {
-        int mid = KING + king_mid_table[7 - bking.second][bking.first]; // mirror for black
-        int end = KING + king_end_table[7 - bking.second][bking.first];
-        kingEvalB = (mid * mid_weight + end * end_weight) / phase_max;
-    }
+    // attack maps once, then every term that needs them
+    EvalInfo ei;
+    buildEvalInfo(pos, pawns, ei);
 
-    // pawns and penalties
-    auto pawns = count_pawns(pos);
-    auto whiteP = pawns.first;
-    auto blackP = pawns.second;
+    mg += ei.mobilityMg[WHITE] - ei.mobilityMg[BLACK];
+    eg += ei.mobilityEg[WHITE] - ei.mobilityEg[BLACK];
 
-    pawnPenW = whiteP[1] * 12 + whiteP[2] * 15;
-    pawnPenB = blackP[1] * 12 + blackP[2] * 15;
+    int threatMg[2] = {0, 0}, threatEg[2] = {0, 0};
+    evaluateThreats(pos, ei, WHITE, threatMg[WHITE], threatEg[WHITE]);
+    evaluateThreats(pos, ei, BLACK, threatMg[BLACK], threatEg[BLACK]);
+    mg += threatMg[WHITE] - threatMg[BLACK];
+    eg += threatEg[WHITE] - threatEg[BLACK];
 
-    auto king_pen = evaluateKingSafety(pos, wking, bking);
-    kingSafetyW = king_pen.first;
-    kingSafetyB = king_pen.second;
+    mg -= evaluateKingSafety(pos, ei, WHITE) - evaluateKingSafety(pos, ei, BLACK);
 
-    int wm = materialW + pstW + kingEvalW - pawnPenW - kingSafetyW;
-    int bm = materialB + pstB + kingEvalB - pawnPenB - kingSafetyB;
+    // positional terms are capped (POSITIONAL_MAX), that is what makes the lazy exit sound;
+    // material + PST и фаза ведутся в Position инкрементально (белые минус чёрные)
+    mg = pos.psqScoreMg() + std::clamp(mg, -POSITIONAL_MAX, POSITIONAL_MAX);
+    eg = pos.psqScoreEg() + std::clamp(eg, -POSITIONAL_MAX, POSITIONAL_MAX);
 
-    int score = wm - bm;
+    // tapered: phase = PHASE_MAX — чистый миттельшпиль, 0 — эндшпиль
+    int phase = std::min(pos.gamePhase(), PHASE_MAX);
+    int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
 
     constexpr int INF = 1000000000;
     if (score > INF-1) score = INF-1;
@@ -400,4 +181,91 @@ int evaluate(const Position& pos) {
     if (!pos.isWhiteToMove()) score = -score;
 
     return score;
-}
\ No newline at end of file
+}
+
+// Кэш оценок по ключу позиции: одно 64-битное слово на запись — старшие
+// 48 бит ключа и оценка в младших 16. Слово пишется атомарно, так что
+// разорванных записей не бывает, а потоки делят кэш без блокировок.
+constexpr size_t EVAL_CACHE_SIZE = 1 << 18; // 2 MB
+constexpr uint64_t EVAL_CACHE_MASK = 0xFFFF;
+static std::atomic<uint64_t> evalCache[EVAL_CACHE_SIZE];
+
+static inline bool probeEvalCache(uint64_t key, int& score) {
+    uint64_t e = evalCache[key & (EVAL_CACHE_SIZE - 1)].load(std::memory_order_relaxed);
+    if (((e ^ key) & ~EVAL_CACHE_MASK) != 0) return false;
+    score = int16_t(uint16_t(e & EVAL_CACHE_MASK));
+    return true;
+}
+
+static int evaluateAndCache(const Position& pos) {
+    uint64_t key = pos.getHash();
+    // сеть включается опцией UseNNUE, ничьи по материалу решаются до неё
+    int raw = !nnue::active() ? evaluateUncached(pos)
+            : pos.isInsufficientMaterial() ? 0
+            : nnue::evaluate(pos);
+    // оценки в int16, реальные значения далеко внутри
+    int score = std::clamp(raw, -32000, 32000);
+    evalCache[key & (EVAL_CACHE_SIZE - 1)].store((key & ~EVAL_CACHE_MASK) | uint16_t(int16_t(score)),
+                                                 std::memory_order_relaxed);
+    return score;
+}
+
+int evaluate(const Position& pos) {
+    int score;
+    if (probeEvalCache(pos.getHash(), score)) return score;
+    return evaluateAndCache(pos);
+}
+
+// Счётчики ленивой оценки: свои у каждого потока, в общие атомики
+// сливаются пачками и при завершении потока.
+static std::atomic<uint64_t> lazyCallsTotal{0}, lazyExitsTotal{0};
+
+struct LazyCounters {
+    uint64_t calls = 0, exits = 0;
+
+    void flush() {
+        lazyCallsTotal.fetch_add(calls, std::memory_order_relaxed);
+        lazyExitsTotal.fetch_add(exits, std::memory_order_relaxed);
+        calls = exits = 0;
+    }
+    ~LazyCounters() { flush(); }
+};
+static thread_local LazyCounters lazyCounters;
+
+int evaluate(const Position& pos, int alpha, int beta, bool& lazy) {
+    lazy = false;
+    int score;
+    if (probeEvalCache(pos.getHash(), score)) return score;
+
+    LazyCounters& c = lazyCounters;
+    if (++c.calls == 4096) c.flush();
+
+    // the network is a single pass, only the classic terms can be skipped
+    if (!nnue::active() && !pos.isInsufficientMaterial()) {
+        int phase = std::min(pos.gamePhase(), PHASE_MAX);
+        int estimate = (pos.psqScoreMg() * phase + pos.psqScoreEg() * (PHASE_MAX - phase)) / PHASE_MAX;
+        if (!pos.isWhiteToMove()) estimate = -estimate;
+
+        if (estimate - LAZY_MARGIN >= beta || estimate + LAZY_MARGIN <= alpha) {
+            ++c.exits;
+            lazy = true;
+            return std::clamp(estimate, -32000, 32000);
+        }
+    }
+    return evaluateAndCache(pos);
+}
+
+LazyEvalStats lazyEvalStats() {
+    return {lazyCallsTotal.load(std::memory_order_relaxed) + lazyCounters.calls,
+            lazyExitsTotal.load(std::memory_order_relaxed) + lazyCounters.exits};
+}
+
+void resetLazyEvalStats() {
+    lazyCounters.calls = lazyCounters.exits = 0;
+    lazyCallsTotal.store(0, std::memory_order_relaxed);
+    lazyExitsTotal.store(0, std::memory_order_relaxed);
+}
+
+void clearEvalCache() {
+    for (auto& slot : evalCache) slot.store(0, std::memory_order_relaxed);
+}
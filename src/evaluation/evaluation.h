@@ -1,8 +1,32 @@
 #ifndef EVALUATION_H
 #define EVALUATION_H
 
+#include <cstdint>
 #include "../position/position.h"
 
 int evaluate(const Position& pos);
 
+/* Windowed entry point for quiescence. When material + PST alone is more
+   than LAZY_MARGIN outside (alpha, beta) the remaining terms are skipped,
+   that estimate is returned and lazy is set; such a score is not exact
+   and must not be cached or stored as a static eval. The full evaluation
+   clamps the sum of pawn structure, mobility, threats and king safety to
+   +-(LAZY_MARGIN - 1) in both phases, so it is always within LAZY_MARGIN
+   of the estimate and the estimate fails high or low exactly when the full
+   score would. */
+constexpr int LAZY_MARGIN = 400;
+int evaluate(const Position& pos, int alpha, int beta, bool& lazy);
+
+/* windowed calls that reached the evaluator (cache hits excluded) and how
+   many of them exited early, summed over threads */
+struct LazyEvalStats {
+    uint64_t calls;
+    uint64_t exits;
+};
+LazyEvalStats lazyEvalStats();
+void resetLazyEvalStats();
+
+/* forgets every cached score, needed whenever the evaluator itself changes */
+void clearEvalCache();
+
 #endif // EVALUATION_H
\ No newline at end of file
@@ -0,0 +1,423 @@
+#include "nnue.h"
+#include "../bitboard/bitboard.h"
+#include "../fen/fen.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHINY_NNUE_X86 1
+#include <immintrin.h>
+#else
+#define SHINY_NNUE_X86 0
+#endif
+
+namespace nnue {
+
+bool useNetwork = false;
+
+namespace {
+
+constexpr uint32_t NET_MAGIC = 0x4E4E4853; // "SHNN"
+constexpr uint32_t NET_VERSION = 1;
+
+/* fixed-point scales of the trained network: accumulator in QA units,
+   output weights in QB units, result mapped to centipawns by EVAL_SCALE */
+constexpr int QA = 255;
+constexpr int QB = 64;
+constexpr int EVAL_SCALE = 400;
+
+constexpr int MAX_PLY = 256;
+
+/* load() rejects a network that scores the start position beyond this */
+constexpr int START_SCORE_MAX = 400;
+constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct Network {
+    alignas(64) int16_t ftWeights[INPUTS * HIDDEN];
+    alignas(64) int16_t ftBias[HIDDEN];
+    alignas(64) int16_t outWeights[2 * HIDDEN]; // side to move first, then the other side
+    int32_t outBias;
+};
+
+std::unique_ptr<Network> net;
+bool enabled = false;
+
+/* colour, dense type index and square of a piece that appeared or vanished */
+struct PieceSq {
+    int8_t color;
+    int8_t index;
+    int8_t sq;
+};
+
+/* one ply of the accumulator stack */
+struct alignas(64) Accumulator {
+    int16_t acc[2][HIDDEN]; // [perspective]
+    uint64_t key;
+    bool computed[2];
+    /* the step into this ply cannot be done incrementally for that perspective:
+       first ply of a chain or the king crossed the mirror line */
+    bool refresh[2];
+    uint8_t addCount, removeCount;
+    PieceSq added[2], removed[2];
+};
+
+struct AccumulatorStack {
+    Accumulator plies[MAX_PLY];
+    int top = -1;
+};
+
+/* allocated on first use so that threads running the classic eval pay nothing */
+thread_local std::unique_ptr<AccumulatorStack> localStack;
+
+AccumulatorStack& stack() {
+    if (!localStack) localStack = std::make_unique<AccumulatorStack>();
+    return *localStack;
+}
+
+/* ---------- kernels ---------- */
+
+using UpdateFn = void (*)(int16_t* dst, const int16_t* src,
+                          const int16_t* const* add, int addCount,
+                          const int16_t* const* sub, int subCount);
+using OutputFn = int32_t (*)(const int16_t* us, const int16_t* them, const int16_t* weights);
+
+#if !SHINY_NNUE_X86
+// на x86-64 всегда есть хотя бы SSE2, скалярные ядра нужны только на прочих платформах
+
+inline int32_t crelu(int16_t x) {
+    return std::clamp<int32_t>(x, 0, QA);
+}
+
+void updateScalar(int16_t* dst, const int16_t* src,
+                  const int16_t* const* add, int addCount,
+                  const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < HIDDEN; ++i) {
+        int16_t v = src[i];
+        for (int a = 0; a < addCount; ++a) v += add[a][i];
+        for (int s = 0; s < subCount; ++s) v -= sub[s][i];
+        dst[i] = v;
+    }
+}
+
+int32_t outputScalar(const int16_t* us, const int16_t* them, const int16_t* weights) {
+    int32_t sum = 0;
+    for (int i = 0; i < HIDDEN; ++i) {
+        sum += crelu(us[i]) * weights[i];
+        sum += crelu(them[i]) * weights[HIDDEN + i];
+    }
+    return sum;
+}
+
+#else
+// SSE2 входит в базовый x86-64, AVX2 включается только при поддержке процессором
+
+void updateSse2(int16_t* dst, const int16_t* src,
+                const int16_t* const* add, int addCount,
+                const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(src + i));
+        for (int a = 0; a < addCount; ++a)
+            v = _mm_add_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(add[a] + i)));
+        for (int s = 0; s < subCount; ++s)
+            v = _mm_sub_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(sub[s] + i)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+}
+
+int32_t outputSse2(const int16_t* us, const int16_t* them, const int16_t* weights) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa = _mm_set1_epi16(QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int half = 0; half < 2; ++half) {
+        const int16_t* acc = half ? them : us;
+        const int16_t* w = weights + half * HIDDEN;
+        for (int i = 0; i < HIDDEN; i += 8) {
+            __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+            v = _mm_min_epi16(_mm_max_epi16(v, zero), qa);
+            // QA * weight fits in int16 only for small weights, so widen through madd
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(w + i))));
+        }
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2")))
+void updateAvx2(int16_t* dst, const int16_t* src,
+                const int16_t* const* add, int addCount,
+                const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i));
+        for (int a = 0; a < addCount; ++a)
+            v = _mm256_add_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(add[a] + i)));
+        for (int s = 0; s < subCount; ++s)
+            v = _mm256_sub_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(sub[s] + i)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+}
+
+__attribute__((target("avx2")))
+int32_t outputAvx2(const int16_t* us, const int16_t* them, const int16_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int half = 0; half < 2; ++half) {
+        const int16_t* acc = half ? them : us;
+        const int16_t* w = weights + half * HIDDEN;
+        for (int i = 0; i < HIDDEN; i += 16) {
+            __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+            v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i))));
+        }
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+struct Kernels {
+    UpdateFn update;
+    OutputFn output;
+    const char* name;
+};
+
+Kernels pickKernels() {
+#if SHINY_NNUE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {updateAvx2, outputAvx2, "avx2"};
+    return {updateSse2, outputSse2, "sse2"};
+#else
+    return {updateScalar, outputScalar, "scalar"};
+#endif
+}
+
+const Kernels kernels = pickKernels();
+
+/* ---------- features ---------- */
+
+/* square as seen by `perspective`: flipped for black, mirrored to files a-d
+   when that side's king is on files e-h */
+inline int orient(bool perspective, int kingSq) {
+    int flip = perspective ? 0 : 56;
+    int mirror = kingSq >= 0 && fileOf(kingSq) >= 4 ? 7 : 0;
+    return flip ^ mirror;
+}
+
+inline int featureIndex(bool perspective, int orientation, bool color, int index, int sq) {
+    return ((color == perspective ? 0 : 6) + index) * 64 + (sq ^ orientation);
+}
+
+inline const int16_t* featureRow(int feature) {
+    return net->ftWeights + feature * HIDDEN;
+}
+
+/* accumulator of one perspective from scratch */
+void refreshAccumulator(const Position& pos, bool perspective, int16_t* out) {
+    const int16_t* rows[32];
+    int count = 0;
+    int orientation = orient(perspective, pos.kingSquare(perspective));
+
+    std::memcpy(out, net->ftBias, sizeof(net->ftBias));
+    for (bool color : {true, false}) {
+        for (int i = 0; i < PIECE_IDX_NB; ++i) {
+            Bitboard b = pos.pieces(pieceByIndex[i], color);
+            while (b) {
+                rows[count++] = featureRow(featureIndex(perspective, orientation, color, i, popLsb(b)));
+                if (count == 32) {
+                    kernels.update(out, out, rows, count, nullptr, 0);
+                    count = 0;
+                }
+            }
+        }
+    }
+    if (count) kernels.update(out, out, rows, count, nullptr, 0);
+}
+
+/* brings the top ply up to date for `perspective`, walking back to the nearest
+   computed ply and replaying the piece changes, or refreshing when the chain
+   is broken on the way */
+void updateAccumulator(AccumulatorStack& s, const Position& pos, bool perspective) {
+    Accumulator& top = s.plies[s.top];
+    if (top.computed[perspective]) return;
+
+    int i = s.top;
+    while (!s.plies[i].computed[perspective]) {
+        if (s.plies[i].refresh[perspective] || i == 0) {
+            refreshAccumulator(pos, perspective, top.acc[perspective]);
+            top.computed[perspective] = true;
+            return;
+        }
+        --i;
+    }
+
+    // король этой стороны на пути не пересекал линию отражения, ориентация общая
+    int orientation = orient(perspective, pos.kingSquare(perspective));
+    for (++i; i <= s.top; ++i) {
+        Accumulator& cur = s.plies[i];
+        const int16_t* add[2];
+        const int16_t* sub[2];
+        for (int a = 0; a < cur.addCount; ++a) {
+            const PieceSq& p = cur.added[a];
+            add[a] = featureRow(featureIndex(perspective, orientation, p.color, p.index, p.sq));
+        }
+        for (int r = 0; r < cur.removeCount; ++r) {
+            const PieceSq& p = cur.removed[r];
+            sub[r] = featureRow(featureIndex(perspective, orientation, p.color, p.index, p.sq));
+        }
+        kernels.update(cur.acc[perspective], s.plies[i - 1].acc[perspective],
+                       add, cur.addCount, sub, cur.removeCount);
+        cur.computed[perspective] = true;
+    }
+}
+
+void resetTo(AccumulatorStack& s, uint64_t key) {
+    s.top = 0;
+    Accumulator& base = s.plies[0];
+    base.key = key;
+    base.computed[0] = base.computed[1] = false;
+    base.refresh[0] = base.refresh[1] = true;
+    base.addCount = base.removeCount = 0;
+}
+
+/* output layer on the two perspectives, side to move first */
+int score(const int16_t* us, const int16_t* them) {
+    int64_t sum = kernels.output(us, them, net->outWeights);
+    return int((sum + net->outBias) * EVAL_SCALE / (QA * QB));
+}
+
+void updateActive() {
+    useNetwork = enabled && net != nullptr;
+}
+
+} // namespace
+
+bool load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    uint32_t header[4];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (header[0] != NET_MAGIC || header[1] != NET_VERSION ||
+        header[2] != uint32_t(INPUTS) || header[3] != uint32_t(HIDDEN)) return false;
+
+    auto fresh = std::make_unique<Network>();
+    in.read(reinterpret_cast<char*>(fresh->ftWeights), sizeof(fresh->ftWeights));
+    in.read(reinterpret_cast<char*>(fresh->ftBias), sizeof(fresh->ftBias));
+    in.read(reinterpret_cast<char*>(fresh->outWeights), sizeof(fresh->outWeights));
+    in.read(reinterpret_cast<char*>(&fresh->outBias), sizeof(fresh->outBias));
+    if (!in) return false;
+
+    // обученная сеть оценивает симметричную начальную позицию почти в ноль; сеть со
+    // сдвигом в тысячи сантипешек (случайная, битая) ломает отсечения stand pat и раздувает quiescence
+    std::swap(net, fresh);
+    Position start;
+    decodeFEN(START_FEN, start);
+    if (std::abs(evaluateRefreshed(start)) > START_SCORE_MAX) {
+        std::swap(net, fresh);
+        return false;
+    }
+
+    updateActive();
+    return true;
+}
+
+void setEnabled(bool on) {
+    enabled = on;
+    updateActive();
+}
+
+const char* simdName() {
+    return kernels.name;
+}
+
+void pushMove(const Position& after, const Move& m, const UndoInfo& undo) {
+    AccumulatorStack& s = stack();
+    bool linked = s.top >= 0 && s.plies[s.top].key == undo.key;
+    // слишком длинная цепочка (ходы из UCI): начинаем заново
+    if (s.top + 1 >= MAX_PLY) {
+        s.top = -1;
+        linked = false;
+    }
+
+    Accumulator& cur = s.plies[++s.top];
+    cur.key = after.getHash();
+    cur.computed[0] = cur.computed[1] = false;
+    cur.refresh[0] = cur.refresh[1] = !linked;
+    cur.addCount = cur.removeCount = 0;
+
+    bool mover = !after.isWhiteToMove();
+    int from = m.from(), to = m.to();
+    int placed = pieceIndex(after.pieceTypeAt(to));
+    int moved = m.promotion() != EMPTY ? PAWN_IDX : placed;
+
+    cur.removed[cur.removeCount++] = {int8_t(mover), int8_t(moved), int8_t(from)};
+    cur.added[cur.addCount++] = {int8_t(mover), int8_t(placed), int8_t(to)};
+
+    if (m.flag() == Move::CASTLING) {
+        int y = rankOf(to);
+        int rookFrom = makeSquare(m.isCastleShort() ? 7 : 0, y);
+        int rookTo = makeSquare(m.isCastleShort() ? 5 : 3, y);
+        cur.removed[cur.removeCount++] = {int8_t(mover), int8_t(ROOK_IDX), int8_t(rookFrom)};
+        cur.added[cur.addCount++] = {int8_t(mover), int8_t(ROOK_IDX), int8_t(rookTo)};
+    } else if (undo.captured != EMPTY) {
+        int capSq = m.isEnPassant() ? (mover ? to - 8 : to + 8) : to;
+        cur.removed[cur.removeCount++] = {int8_t(!mover), int8_t(pieceIndex(undo.captured)), int8_t(capSq)};
+    }
+
+    if (moved == KING_IDX && (fileOf(from) >= 4) != (fileOf(to) >= 4))
+        cur.refresh[mover] = true;
+
+    // такой ply пересчитываем сразу и один раз: внутренние узлы PVS не оцениваются,
+    // и иначе каждый лист поддерева делал бы полный пересчёт сам
+    for (bool p : {true, false}) {
+        if (cur.refresh[p]) {
+            refreshAccumulator(after, p, cur.acc[p]);
+            cur.computed[p] = true;
+        }
+    }
+}
+
+void popMove(uint64_t childKey) {
+    AccumulatorStack& s = stack();
+    if (s.top >= 0 && s.plies[s.top].key == childKey) --s.top;
+}
+
+int evaluate(const Position& pos) {
+    AccumulatorStack& s = stack();
+    if (s.top < 0 || s.plies[s.top].key != pos.getHash()) resetTo(s, pos.getHash());
+
+    updateAccumulator(s, pos, WHITE);
+    updateAccumulator(s, pos, BLACK);
+
+    const Accumulator& top = s.plies[s.top];
+    bool stm = pos.isWhiteToMove();
+#ifndef NDEBUG
+    {
+        alignas(64) int16_t fresh[HIDDEN];
+        for (bool p : {true, false}) {
+            refreshAccumulator(pos, p, fresh);
+            assert(std::memcmp(fresh, top.acc[p], sizeof(fresh)) == 0);
+        }
+    }
+#endif
+    return score(top.acc[stm], top.acc[!stm]);
+}
+
+int evaluateRefreshed(const Position& pos) {
+    alignas(64) int16_t acc[2][HIDDEN];
+    refreshAccumulator(pos, WHITE, acc[WHITE]);
+    refreshAccumulator(pos, BLACK, acc[BLACK]);
+    bool stm = pos.isWhiteToMove();
+    return score(acc[stm], acc[!stm]);
+}
+
+} // namespace nnue
@@ -0,0 +1,56 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+#include "../position/position.h"
+
+/* Optional network evaluator: (768 -> HIDDEN) x 2 perspectives -> 1.
+   Per perspective the inputs are colour (own / enemy) x piece type x
+   square, the board flipped for black and mirrored left-right when that
+   side's king stands on files e-h. Accumulators are int16 and kept on a
+   thread-local stack that Position::makeMove/unmakeMove push and pop
+   while the network is in use; they are brought up to date lazily, at
+   evaluate(), from the nearest computed ancestor. Plies that start a chain
+   or where a king crossed the mirror line are refreshed as they are
+   pushed, so that walk never has to refresh the top again. */
+namespace nnue {
+
+constexpr int INPUTS = 768;
+constexpr int HIDDEN = 256;
+
+/* true while UseNNUE is on and a network is loaded */
+extern bool useNetwork;
+
+inline bool active() {
+    return useNetwork;
+}
+
+/* reads a network written as: "SHNN", version, INPUTS, HIDDEN (uint32
+   each), int16 feature weights [INPUTS][HIDDEN], int16 feature biases
+   [HIDDEN], int16 output weights [2 * HIDDEN], int32 output bias, all
+   little endian. False (old network kept) on any mismatch, and for a
+   network that scores the start position beyond +-400 cp: such a bias
+   for one side leaves quiescence without stand-pat cutoffs */
+bool load(const std::string& path);
+
+/* UseNNUE; the classic evaluator stays in charge until a network is loaded */
+void setEnabled(bool on);
+
+/* "avx2", "sse2" or "scalar", chosen at runtime */
+const char* simdName();
+
+/* make/unmake hooks, only called while active() */
+void pushMove(const Position& after, const Move& m, const UndoInfo& undo);
+void popMove(uint64_t childKey);
+
+/* score from the side to move, same convention as evaluate() */
+int evaluate(const Position& pos);
+
+/* same score from accumulators refreshed from scratch, stack untouched;
+   the reference the incremental path has to match */
+int evaluateRefreshed(const Position& pos);
+
+} // namespace nnue
+
+#endif // NNUE_H
@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bitboard/attacks.h"
+#include "evaluation/nnue.h"
+#include "fen/fen.h"
+#include "searching/zobrist.h"
+
+/*
+   shiny-nnue-test: the incremental accumulators against a full refresh.
+   A random network is written to a temporary file and loaded, then move
+   trees are walked with makeMove/unmakeMove and nnue::evaluate() is
+   compared with nnue::evaluateRefreshed() along the way. Interior nodes
+   are evaluated only now and then, so updates also replay several plies.
+*/
+
+namespace {
+
+// веса по ±64: сумма 32 строк в int16 не переполняется; выходные веса "чужой"
+// половины — минус "своей", чтобы начальная позиция давала 0 и load() принял сеть
+bool writeRandomNet(const std::string& path) {
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> weight(-64, 64);
+
+    std::ofstream out(path, std::ios::binary);
+    uint32_t header[4] = {0x4E4E4853, 1, uint32_t(nnue::INPUTS), uint32_t(nnue::HIDDEN)};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<int16_t> w(size_t(nnue::INPUTS) * nnue::HIDDEN + nnue::HIDDEN);
+    for (int16_t& x : w) x = int16_t(weight(rng));
+    std::vector<int16_t> outWeights(2 * nnue::HIDDEN);
+    for (int i = 0; i < nnue::HIDDEN; ++i) {
+        outWeights[i] = int16_t(weight(rng));
+        outWeights[nnue::HIDDEN + i] = int16_t(-outWeights[i]);
+    }
+    out.write(reinterpret_cast<const char*>(w.data()), w.size() * sizeof(int16_t));
+    out.write(reinterpret_cast<const char*>(outWeights.data()), outWeights.size() * sizeof(int16_t));
+    int32_t bias = 0;
+    out.write(reinterpret_cast<const char*>(&bias), sizeof(bias));
+    return bool(out);
+}
+
+struct Checker {
+    uint64_t checked = 0;
+    uint64_t failed = 0;
+
+    void check(const Position& pos) {
+        ++checked;
+        int incremental = nnue::evaluate(pos);
+        int refreshed = nnue::evaluateRefreshed(pos);
+        if (incremental != refreshed && failed++ < 10) {
+            std::string fen;
+            encodeFEN(fen, pos);
+            std::cout << "mismatch " << fen << ": incremental " << incremental
+                      << ", refreshed " << refreshed << std::endl;
+        }
+    }
+
+    void walk(Position& pos, int depth) {
+        // листья всегда, внутренние узлы через раз по биту ключа
+        if (depth == 0 || (pos.getHash() >> 17) & 1) check(pos);
+        if (depth == 0) return;
+
+        for (const Move& m : pos.getLegalMoves()) {
+            UndoInfo undo;
+            pos.makeMove(m, undo);
+            walk(pos, depth - 1);
+            pos.unmakeMove(m, undo);
+        }
+    }
+
+    /* one long line, deeper than any search, checked on the way down and back */
+    void line(Position& pos, int plies) {
+        std::vector<std::pair<Move, UndoInfo>> path;
+        std::mt19937 rng(plies);
+        for (int i = 0; i < plies; ++i) {
+            MoveList moves = pos.getLegalMoves();
+            if (moves.empty()) break;
+            Move m = moves[rng() % moves.size()];
+            path.push_back({m, UndoInfo()});
+            pos.makeMove(m, path.back().second);
+            if (i % 3 == 0) check(pos);
+        }
+        while (!path.empty()) {
+            pos.unmakeMove(path.back().first, path.back().second);
+            path.pop_back();
+            check(pos);
+        }
+    }
+};
+
+} // namespace
+
+int main() {
+    initZobrist();
+    initAttacks();
+
+    std::string path = (std::filesystem::temp_directory_path() / "shiny-nnue-test.bin").string();
+    bool ok = writeRandomNet(path) && nnue::load(path);
+    std::remove(path.c_str());
+    if (!ok) {
+        std::cout << "cannot write or load " << path << std::endl;
+        return 1;
+    }
+    nnue::setEnabled(true);
+
+    // castling, en passant, promotions and kings crossing the mirror line
+    const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    Checker checker;
+    for (const char* fen : fens) {
+        Position pos;
+        decodeFEN(fen, pos);
+        checker.walk(pos, 3);
+        checker.line(pos, 300);
+    }
+
+    std::cout << nnue::simdName() << ": " << checker.checked << " positions, "
+              << checker.failed << " mismatches" << std::endl;
+    return checker.failed == 0 ? 0 : 1;
+}
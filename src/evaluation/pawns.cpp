@@ -0,0 +1,94 @@
+#include "pawns.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// пешечная структура меняется редко: 8K записей на поток хватает с запасом
+constexpr size_t PAWN_TABLE_SIZE = 1 << 13;
+
+constexpr int DOUBLED_PENALTY = 12;
+constexpr int ISOLATED_PENALTY = 15;
+
+// бонус проходной по рангу с её стороны (0 = первый ряд)
+constexpr int passed_mg[8] = {0, 5, 10, 15, 25, 40, 60, 0};
+constexpr int passed_eg[8] = {0, 10, 20, 35, 60, 90, 130, 0};
+
+static void evaluateSide(const Position& pos, bool white, PawnEntry& e) {
+    Bitboard ours = pos.pieces(PAWN, white);
+    Bitboard theirs = pos.pieces(PAWN, !white);
+
+    Bitboard attacks = white ? shiftWest(ours) << 8 | shiftEast(ours) << 8
+                             : shiftWest(ours) >> 8 | shiftEast(ours) >> 8;
+
+    // всё, что чужие пешки видят впереди себя (свой файл и соседние): там наша не проходная
+    Bitboard theirSpan = white ? southFill(theirs >> 8) : northFill(theirs << 8);
+    Bitboard blockers = theirSpan | shiftEast(theirSpan) | shiftWest(theirSpan);
+
+    e.attacks[white] = attacks;
+    e.passed[white] = ours & ~blockers;
+
+    int doubled = 0, isolated = 0;
+    for (int f = 0; f < 8; ++f) {
+        int n = popCount(ours & fileBB(f));
+        if (n == 0) continue;
+        doubled += n - 1;
+        Bitboard neighbours = shiftEast(fileBB(f)) | shiftWest(fileBB(f));
+        if (!(ours & neighbours)) isolated += n;
+    }
+
+    int penalty = doubled * DOUBLED_PENALTY + isolated * ISOLATED_PENALTY;
+    int mg = -penalty, eg = -penalty;
+    Bitboard passed = e.passed[white];
+    while (passed) {
+        int sq = popLsb(passed);
+        int rank = white ? rankOf(sq) : 7 - rankOf(sq);
+        mg += passed_mg[rank];
+        eg += passed_eg[rank];
+    }
+    e.mg[white] = mg;
+    e.eg[white] = eg;
+}
+
+static void evaluatePawns(const Position& pos, PawnEntry& e) {
+    e.key = pos.getPawnKey();
+    evaluateSide(pos, WHITE, e);
+    evaluateSide(pos, BLACK, e);
+}
+
+namespace {
+struct PawnTable {
+    std::vector<PawnEntry> entries;
+    // ключ 0 у пустой записи совпал бы с позицией без пешек
+    PawnTable() : entries(PAWN_TABLE_SIZE) {
+        for (auto& e : entries) e.key = ~0ULL;
+    }
+};
+
+// по таблице на слот потока поиска, как killers/history в movepick.cpp
+std::mutex slotsMutex;
+std::vector<std::unique_ptr<PawnTable>> slots;
+thread_local std::unique_ptr<PawnTable> unbound;
+thread_local PawnTable* table = nullptr;
+}
+
+void bindPawnTable(int slot) {
+    std::lock_guard<std::mutex> lk(slotsMutex);
+    if (slot >= int(slots.size())) slots.resize(slot + 1);
+    if (!slots[slot]) slots[slot] = std::make_unique<PawnTable>();
+    table = slots[slot].get();
+}
+
+const PawnEntry& probePawns(const Position& pos) {
+    // свою таблицу поток трогает один: без блокировок и без гонок
+    if (!table) {
+        unbound = std::make_unique<PawnTable>();
+        table = unbound.get();
+    }
+
+    uint64_t key = pos.getPawnKey();
+    PawnEntry& e = table->entries[key & (PAWN_TABLE_SIZE - 1)];
+    if (e.key != key) evaluatePawns(pos, e);
+    return e;
+}
@@ -0,0 +1,24 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include <cstdint>
+#include "../position/position.h"
+
+/* Everything evaluate() needs from the pawn skeleton, indexed by colour
+   (true = white). Depends on pawn placement only, so it is cached by
+   Position::getPawnKey(). */
+struct PawnEntry {
+    uint64_t key;
+    Bitboard passed[2];      // passed pawns
+    Bitboard attacks[2];     // squares attacked by pawns now
+    int16_t mg[2], eg[2];    // structure score: penalties and passed-pawn bonus
+};
+
+/* Pawn hash of the calling thread: probes by pawn key and fills the slot on
+   a miss. Like killers and history (see bindMoveHistory) the tables belong
+   to search thread slots, so a worker keeps its hits across iterations;
+   unbound threads use a private table. */
+const PawnEntry& probePawns(const Position& pos);
+void bindPawnTable(int slot);
+
+#endif // PAWNS_H
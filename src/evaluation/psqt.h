@@ -0,0 +1,129 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <array>
+#include <cstdint>
+#include "../position/position.h"
+
+/* Piece-square tables merged with material: psq_mg[piece][sq] and
+   psq_eg[piece][sq] (piece is a PieceIndex, square a1 = 0) hold
+   value + PST for a white piece, black pieces read square ^ 56.
+   Position keeps their running white-minus-black sums.
+   Every table is constexpr and starts on its own cache line. */
+
+using PieceTable = std::array<int16_t, PIECE_IDX_NB>;
+using PsqTable = std::array<std::array<int16_t, 64>, PIECE_IDX_NB>;
+
+alignas(64) constexpr PieceTable piece_value = {100, 320, 330, 500, 900, 400};
+
+namespace psqt_detail {
+
+using PST = std::array<std::array<int, 8>, 8>;
+
+// pawn
+constexpr PST pawn_table = {{ 
+    {{  0,   0,   0,   0,   0,   0,   0,   0 }},
+    {{  5,  10,  10, -20, -20,  10,  10,   5 }},
+    {{  5,  -5, -10,   0,   0, -10,  -5,   5 }},
+    {{  0,   0,   0,  20,  20,   0,   0,   0 }},
+    {{  5,   5,  10,  25,  25,  10,   5,   5 }},
+    {{ 10,  10,  20,  30,  30,  20,  10,  10 }},
+    {{ 50,  50,  50,  50,  50,  50,  50,  50 }},
+    {{  0,   0,   0,   0,   0,   0,   0,   0 }}
+}}; 
+
+// knight
+constexpr PST knight_table = {{
+    {{-50, -40, -30, -30, -30, -30, -40, -50}},
+    {{-40, -20,   0,   0,   0,   0, -20, -40}},
+    {{-30,   0,  10,  15,  15,  10,   0, -30}},
+    {{-30,   5,  15,  20,  20,  15,   5, -30}},
+    {{-30,   0,  15,  20,  20,  15,   0, -30}},
+    {{-30,   5,  10,  15,  15,  10,   5, -30}},
+    {{-40, -20,   0,   5,   5,   0, -20, -40}},
+    {{-50, -40, -30, -30, -30, -30, -40, -50}}
+}}; 
+
+// bishop
+constexpr PST bishop_table = {{
+    {{-20, -10, -10, -10, -10, -10, -10, -20}},
+    {{-10,   0,   0,   0,   0,   0,   0, -10}},
+    {{-10,   0,  10,  10,  10,  10,   0, -10}},
+    {{-10,   5,   5,  20,  20,   5,   5, -10}},
+    {{-10,   0,  10,  20,  20,  10,   0, -10}},
+    {{-10,  10,  10,  10,  10,  10,  10, -10}},
+    {{-10,   5,   0,   0,   0,   0,   5, -10}},
+    {{-20, -10, -10, -10, -10, -10, -10, -20}}
+}};
+
+// rooks
+constexpr PST rook_table = {{
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
+    {{  5,   5,   5,   10,   10,   5,   5,   5 }},
+    {{  5,   5,   5,   10,   10,   5,   5,   5 }},
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }},
+    {{  0,   0,   0,   10,   10,   0,   0,   0 }}
+}};
+
+// queen
+constexpr PST queen_table = {{
+    {{-20, -10, -10,  -5,  -5, -10, -10, -20}},
+    {{-10,   0,   0,   0,   0,   0,   0, -10}},
+    {{-10,   0,   5,   5,   5,   5,   0, -10}},
+    {{ -5,   0,   5,   5,   5,   5,   0,  -5}},
+    {{  0,   0,   5,   5,   5,   5,   0,  -5}},
+    {{-10,   5,   5,   5,   5,   5,   0, -10}},
+    {{-10,   0,   5,   0,   0,   0,   0, -10}},
+    {{-20, -10, -10,  -5,  -5, -10, -10, -20}}
+}};
+
+// king (mid game)
+constexpr PST king_mid_table = {{
+    {{-30, -40, -40, -50, -50, -40, -40, -30}},
+    {{-30, -40, -40, -50, -50, -40, -40, -30}},
+    {{-30, -40, -40, -50, -50, -40, -40, -30}},
+    {{-30, -40, -40, -50, -50, -40, -40, -30}},
+    {{-20, -30, -30, -40, -40, -30, -30, -20}},
+    {{-10, -20, -20, -20, -20, -20, -20, -10}},
+    {{ 20,  20,   0,   0,   0,   0,  20,  20}},
+    {{ 20,  30,  10,   0,   0,  10,  30,  20}}
+}};
+
+// king (end game)
+constexpr PST king_end_table = {{
+    {{-50, -40, -30, -20, -20, -30, -40, -50}},
+    {{-30, -20, -101,  0,   0, -10, -20, -30}},
+    {{-30, -10,  20,  30,  30,  20, -10, -30}},
+    {{-30, -10,  30,  40,  40,  30, -10, -30}},
+    {{-30, -10,  30,  40,  40,  30, -10, -30}},
+    {{-30, -10,  20,  30,  30,  20, -10, -30}},
+    {{-30, -30,   0,   0,   0,   0, -30, -30}},
+    {{-50, -30, -30, -30, -30, -30, -30, -50}}
+}};
+
+/* tables are [rank][file]; only the king differs between mg and eg */
+constexpr PsqTable build(bool endgame) {
+    const PST* tables[PIECE_IDX_NB] = {
+        &pawn_table, &knight_table, &bishop_table, &rook_table, &queen_table,
+        endgame ? &king_end_table : &king_mid_table
+    };
+    PsqTable res{};
+    for (int p = 0; p < PIECE_IDX_NB; ++p)
+        for (int sq = 0; sq < 64; ++sq)
+            res[p][sq] = int16_t(piece_value[p] + (*tables[p])[sq >> 3][sq & 7]);
+    return res;
+}
+
+} // namespace psqt_detail
+
+alignas(64) constexpr PsqTable psq_mg = psqt_detail::build(false);
+alignas(64) constexpr PsqTable psq_eg = psqt_detail::build(true);
+
+/* game phase per piece, PHASE_MAX = every minor and major piece on the board */
+alignas(64) constexpr PieceTable phase_weight = {0, 1, 1, 2, 4, 0};
+constexpr int PHASE_MAX = 24;
+
+#endif // PSQT_H
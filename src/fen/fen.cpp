@@ -7,6 +7,9 @@ bool decodeFEN(const std::string& fen, Position& pos) {
     std::stringstream ss(fen);
     std::string row;
 
+    // с пустой доски: поверх старой setPiece может стереть кэш уже поставленного короля
+    pos = Position();
+
     for (int i = 7; i >= 0; --i) {
         std::getline(ss, row, '/');
         auto iter = row.begin();
@@ -72,33 +75,39 @@ bool decodeFEN(const std::string& fen, Position& pos) {
 
     // castling rights
     std::getline(additionalParams, row, ' ');
+    short castleRights = 0;
     if (row != "-") {
-        short castleRights = 0;
         auto iter = row.begin();
         while (iter != row.end()) {
             switch (*iter) {
             case 'K':
             castleRights |= 0b0001;
+            break;
             case 'Q':
             castleRights |= 0b0010;
+            break;
             case 'k':
             castleRights |= 0b0100;
+            break;
             case 'q':
             castleRights |= 0b1000;
+            break;
             }
             ++iter;
         }
-        pos.setCastleRights(castleRights);
     }
+    pos.setCastleRights(castleRights);
 
     // en passant target square
     std::getline(additionalParams, row, ' ');
-    if (row != "-") {
-        pos.setEnPassant(int(char(row[0]) - 'a'), int(char(row[1]) - '0'));
+    if (row != "-" && row.size() >= 2) {
+        pos.setEnPassant(int(char(row[0]) - 'a'), int(char(row[1]) - '1'));
     } else {
         pos.setEnPassant(-1, -1);
     }
 
+    pos.refreshHash();
+
     return true;
 }
 
@@ -173,10 +182,8 @@ bool encodeFEN(std::string& fen, const Position& pos) {
     fen.append(" ");
     auto enPassant = pos.getEnPassant();
     if (enPassant.first != -1) {
-        fen.append(std::string(
-            char((int)'a' + enPassant.first), 
-            char((int)'0' + enPassant.second)
-        ));
+        fen.push_back(char((int)'a' + enPassant.first));
+        fen.push_back(char((int)'1' + enPassant.second));
     } else {
         fen.append("-");
     }
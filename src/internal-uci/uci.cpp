@@ -3,37 +3,62 @@
 #include <iostream>
 #include <string>
 #include "searching/pvs.h"
+#include "searching/movepick.h"
 #include <unordered_map>
 
 void uci_loop() {
     std::string line;
     Position pos;
     TranspositionTable tt(TRANSPOSITIONTABLE_SIZE);
-    std::unordered_map<std::string, int> opts;
+    std::unordered_map<std::string, std::string> opts;
+    bool debug = false;
 
     while (std::getline(std::cin, line)) {
         if (line == "uci") {
             std::cout << "id name 11yoShiny" << std::endl;
             std::cout << "id author jonhef" << std::endl;
+            std::cout << "option name Hash type spin default " << TRANSPOSITIONTABLE_SIZE << " min 1 max 65536" << std::endl;
+            std::cout << "option name HashFile type string default <empty>" << std::endl;
+            std::cout << "option name SharedHash type string default <empty>" << std::endl;
+            std::cout << "option name Processes type spin default 1 min 1 max 256" << std::endl;
+            std::cout << "option name EvalFile type string default <empty>" << std::endl;
+            std::cout << "option name UseNNUE type check default false" << std::endl;
             std::cout << "uciok" << std::endl;
         }
         else if (line == "isready") {
             std::cout << "readyok" << std::endl;
         }
         else if (line.rfind("go", 0) == 0) {
-            handleGo(line, pos, tt);
+            handleGo(line, pos, tt, opts, debug);
         } else if (line.rfind("position", 0) == 0) {
             handlePosition(line, pos);
         }
+        else if (line.rfind("perft", 0) == 0) {
+            handlePerft(line, pos, false);
+        }
+        else if (line.rfind("divide", 0) == 0) {
+            handlePerft(line, pos, true);
+        }
+        else if (line.rfind("savehash", 0) == 0) {
+            handleHashFile(line, opts, tt, true);
+        }
+        else if (line.rfind("loadhash", 0) == 0) {
+            handleHashFile(line, opts, tt, false);
+        }
         else if (line.rfind("ucinewgame", 0) == 0) {
             pos = Position();
+            tt.clear();
+            clearMoveHistory();
+        }
+        else if (line.rfind("debug", 0) == 0) {
+            debug = line == "debug on";
         }
         else if (line == "quit") {
             break;
         } else if (line == "copyprotection checking") {
             std::cout << "copyprotection checking" << std::endl;
         } else if (line.rfind("setoption", 0) == 0) {
-            
+            handleOpts(line, opts, tt);
         }
     }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define UCI_H
 
 #include <string>
+#include <unordered_map>
 #include "position/position.h"
 #include "searching/pvs.h"
 
@@ -9,9 +10,17 @@ constexpr int TRANSPOSITIONTABLE_SIZE = 128; // in megabytes
 
 // helpers
 void handlePosition(const std::string& line, Position& pos);
-void handleGo(const std::string& line, Position& pos, TranspositionTable& tt);
+/* debug ("debug on") adds profiling info strings after the search */
+void handleGo(const std::string& line, Position& pos, TranspositionTable& tt, const std::unordered_map<std::string, std::string>& opts, bool debug = false);
+void handlePerft(const std::string& line, Position& pos, bool divide);
+/* "setoption name <id> [value <x>]", values are kept as strings in opts */
+void handleOpts(const std::string& line, std::unordered_map<std::string, std::string>& opts, TranspositionTable& tt);
+/* "savehash [file]" / "loadhash [file]", the file defaults to the HashFile option */
+void handleHashFile(const std::string& line, const std::unordered_map<std::string, std::string>& opts, TranspositionTable& tt, bool save);
 
 std::string encodeUCIMove(const Move& mv);
+/* returns Move() if moveStr is not a legal move in pos */
+Move parseUCIMove(const std::string& moveStr, const Position& pos);
 
 void uci_loop();
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <iostream>
@@ -5,42 +6,36 @@
 
 #include "position/position.h"
 #include "fen/fen.h"
+#include "evaluation/evaluation.h"
+#include "evaluation/nnue.h"
 #include "searching/pvs.h"
 #include "searching/searching.h"
+#include "perft/perft.h"
+#include "threading/process_split.h"
 #include "uci.h"
 
 constexpr int THREADS = 32;
 
 // UCI → Move
-Move parseUCIMove(const std::string& moveStr) {
-    Move m{};
-    m.fromX = moveStr[0] - 'a';  // file
-    m.fromY = moveStr[1] - '1';  // rank
-    m.toX   = moveStr[2] - 'a';
-    m.toY   = moveStr[3] - '1';
-
-    m.promotion = EMPTY;
-    if (moveStr.size() == 5) {
-        switch (moveStr[4]) {
-            case 'q': m.promotion = QUEEN; break;
-            case 'r': m.promotion = ROOK;  break;
-            case 'b': m.promotion = BISHOP;break;
-            case 'n': m.promotion = KNIGHT;break;
-            default: break;
-        }
+// флаги (рокировка, en passant) берём из списка легальных ходов позиции
+Move parseUCIMove(const std::string& moveStr, const Position& pos) {
+    for (const Move& m : pos.getLegalMoves()) {
+        if (encodeUCIMove(m) == moveStr) return m;
     }
-    return m;
+    return Move();
 }
 
 // Move → UCI
 std::string encodeUCIMove(const Move& mv) {
+    if (mv.isNone()) return "0000";
+
     std::string res;
-    res += char('a' + mv.fromX);  // file
-    res += char('1' + mv.fromY);  // rank
-    res += char('a' + mv.toX);
-    res += char('1' + mv.toY);
-    if (mv.promotion != EMPTY) {
-        switch (mv.promotion) {
+    res += char('a' + mv.fromX());  // file
+    res += char('1' + mv.fromY());  // rank
+    res += char('a' + mv.toX());
+    res += char('1' + mv.toY());
+    if (mv.promotion() != EMPTY) {
+        switch (mv.promotion()) {
             case QUEEN:  res += 'q'; break;
             case ROOK:   res += 'r'; break;
             case BISHOP: res += 'b'; break;
@@ -66,7 +61,7 @@ void handlePosition(const std::string& line, Position& pos) {
         if (iss >> token && token == "moves") {
             std::string moveStr;
             while (iss >> moveStr) {
-                Move m = parseUCIMove(moveStr);
+                Move m = parseUCIMove(moveStr, pos);
                 pos.applyMove(m);
             }
         }
@@ -83,14 +78,21 @@ void handlePosition(const std::string& line, Position& pos) {
         if (iss >> token && token == "moves") {
             std::string moveStr;
             while (iss >> moveStr) {
-                Move m = parseUCIMove(moveStr);
+                Move m = parseUCIMove(moveStr, pos);
                 pos.applyMove(m);
             }
         }
     }
 }
 
-void handleGo(const std::string& line, Position& pos, TranspositionTable& tt) {
+// числовая опция из setoption, def если не задана или не число
+static int optionInt(const std::unordered_map<std::string, std::string>& opts, const std::string& name, int def) {
+    auto it = opts.find(name);
+    if (it == opts.end()) return def;
+    try { return std::stoi(it->second); } catch (...) { return def; }
+}
+
+void handleGo(const std::string& line, Position& pos, TranspositionTable& tt, const std::unordered_map<std::string, std::string>& opts, bool debug) {
     std::istringstream iss(line);
     std::string token;
     iss >> token; // "go"
@@ -111,27 +113,138 @@ void handleGo(const std::string& line, Position& pos, TranspositionTable& tt) {
         else if (token == "infinite") infinite = true;
     }
 
-    SearchResult res;
+    int timeLimit = -1;
+    if (depth <= 0) {
+        if (movetime > 0) {
+            timeLimit = movetime;
+        } else {
+            // простая эвристика для лимита по времени
+            int myTime = pos.isWhiteToMove() ? wtime : btime;
+            int inc    = pos.isWhiteToMove() ? winc : binc;
+            if (myTime <= 0) myTime = 1000; // fallback 1s
+            int moves = movestogo > 0 ? movestogo : 30;
+            timeLimit = myTime / moves + inc;
+            if (timeLimit < 50) timeLimit = 50;
+        }
+    }
+
+    // новый поиск: записи прошлых ходов стареют и вытесняются первыми
+    tt.newSearch();
+    resetLazyEvalStats();
+
+    // несколько процессов делят корень (и TT, если он на SharedHash), потоки — поровну
+    int processes = std::max(1, optionInt(opts, "Processes", 1));
+    int threads = std::max(1, THREADS / processes);
 
-    if (depth > 0) {
-        // ограничение по глубине
-        res = iterativeDeepeningThreadsDepth(pos, depth, tt, THREADS);
-    } else if (movetime > 0) {
-        res = iterativeDeepeningThreadsTime(pos, movetime, tt, THREADS);
+    auto search = [&](const MoveList& moves, const IterationCallback& onIteration) {
+        if (depth > 0) return iterativeDeepeningThreadsDepth(pos, depth, tt, threads, &moves, onIteration);
+        return iterativeDeepeningThreadsTime(pos, timeLimit, tt, threads, &moves, onIteration);
+    };
+
+    SearchResult res;
+    if (processes > 1) {
+        res = searchAcrossProcesses(pos, processes, search);
     } else {
-        // простая эвристика для лимита по времени
-        int myTime = pos.isWhiteToMove() ? wtime : btime;
-        int inc    = pos.isWhiteToMove() ? winc : binc;
-        if (myTime <= 0) myTime = 1000; // fallback 1s
-        int moves = movestogo > 0 ? movestogo : 30;
-        int alloc = myTime / moves + inc;
-        if (alloc < 50) alloc = 50;
-        res = iterativeDeepeningThreadsTime(pos, alloc, tt, THREADS);
+        res = search(pos.getLegalMoves(), nullptr);
+    }
+
+    // профилирование ленивой оценки — только в режиме "debug on"
+    LazyEvalStats lazy = lazyEvalStats();
+    if (debug && lazy.calls > 0) {
+        std::cout << "info string lazy eval " << lazy.exits << "/" << lazy.calls << " early exits ("
+                  << lazy.exits * 100 / lazy.calls << "%)" << std::endl;
     }
 
     std::cout << "bestmove " << encodeUCIMove(res.bestMove) << std::endl;
 }
 
-void handleOpts(const std::string& line, std::unordered_map<std::string, std::string>& opts) {
+// "perft <depth> [threads N] [hash MB]", divide печатает счёт по каждому корневому ходу
+void handlePerft(const std::string& line, Position& pos, bool divide) {
+    std::istringstream iss(line);
+    std::string token;
+    iss >> token; // "perft" / "divide"
+
+    int depth = 1;
+    PerftOptions opts;
+    iss >> depth;
+    while (iss >> token) {
+        if (token == "threads") iss >> opts.threads;
+        else if (token == "hash") iss >> opts.hashMB;
+    }
+
+    printPerft(runPerft(pos, depth, opts, divide), std::cout);
+}
+
+void handleOpts(const std::string& line, std::unordered_map<std::string, std::string>& opts, TranspositionTable& tt) {
+    std::istringstream iss(line);
+    std::string token, name, value;
+    iss >> token; // "setoption"
+
+    // имя и значение могут состоять из нескольких слов
+    std::string* target = nullptr;
+    while (iss >> token) {
+        if (token == "name") target = &name;
+        else if (token == "value") target = &value;
+        else if (target) *target += (target->empty() ? "" : " ") + token;
+    }
+    if (name.empty()) return;
+
+    opts[name] = value;
+
+    if (name == "Hash") {
+        int mb = 0;
+        try { mb = std::stoi(value); } catch (...) { return; }
+        if (mb <= 0) return;
+        // общий сегмент другого размера не бывает: таблица становится своей
+        if (tt.isShared()) {
+            std::cout << "info string Hash " << mb << " MB leaves SharedHash " << opts["SharedHash"]
+                      << ", the table is private now" << std::endl;
+            opts.erase("SharedHash");
+        }
+        tt.resize(size_t(mb));
+    }
+    else if (name == "SharedHash") {
+        // пустое значение — обратно к своей (приватной) таблице
+        if (value.empty() || value == "<empty>") {
+            if (tt.isShared()) tt.resize(tt.sizeInMB());
+        } else if (!tt.attachShared(value[0] == '/' ? value : "/" + value)) {
+            std::cout << "info string cannot map shared hash " << value << std::endl;
+        }
+    }
+    else if (name == "EvalFile" || name == "UseNNUE") {
+        if (name == "UseNNUE") {
+            nnue::setEnabled(value == "true");
+        } else if (!value.empty() && value != "<empty>") {
+            bool ok = nnue::load(value);
+            std::cout << "info string EvalFile " << value << (ok ? " loaded" : " failed") << std::endl;
+        }
+        if (nnue::active())
+            std::cout << "info string NNUE evaluation, " << nnue::simdName() << " kernels" << std::endl;
+        else if (name == "UseNNUE" && value == "true")
+            std::cout << "info string no network loaded, classic eval in use" << std::endl;
+
+        // оценки другого вычислителя в кэше и TT больше не годятся
+        clearEvalCache();
+        tt.clear();
+    }
+}
+
+void handleHashFile(const std::string& line, const std::unordered_map<std::string, std::string>& opts, TranspositionTable& tt, bool save) {
+    std::istringstream iss(line);
+    std::string token, path;
+    iss >> token; // "savehash" / "loadhash"
+    std::getline(iss >> std::ws, path);
+
+    if (path.empty()) {
+        auto it = opts.find("HashFile");
+        if (it != opts.end()) path = it->second;
+    }
+    if (path.empty() || path == "<empty>") {
+        std::cout << "info string no hash file, set HashFile or pass a path" << std::endl;
+        return;
+    }
 
+    bool ok = save ? tt.save(path) : tt.load(path);
+    std::cout << "info string " << (save ? "savehash " : "loadhash ") << path
+              << (ok ? " ok" : " failed") << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "perft.h"
+
+#include <chrono>
+#include <iostream>
+#include "fen/fen.h"
+#include "internal-uci/uci.h"
+#include "threading/thread_pool.h"
+
+PerftHash::PerftHash(size_t sizeMB) {
+    size_t entries = (sizeMB * 1024ULL * 1024ULL) / sizeof(Entry);
+    // степень двойки, чтобы индексировать маской
+    size_t size = 1;
+    while (size * 2 <= entries) size *= 2;
+    table = std::vector<Entry>(size);
+    mask = size - 1;
+}
+
+bool PerftHash::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    const Entry& e = table[key & mask];
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    uint64_t check = e.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || int(data & 0xFF) != depth) return false;
+    nodes = data >> 8;
+    return true;
+}
+
+void PerftHash::store(uint64_t key, int depth, uint64_t nodes) {
+    Entry& e = table[key & mask];
+    uint64_t data = (nodes << 8) | uint64_t(depth & 0xFF);
+    e.check.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+uint64_t perft(Position& pos, int depth, PerftHash* hash) {
+    if (depth <= 0) return 1;
+
+    MoveList moves = pos.getLegalMoves();
+    // bulk counting: на последнем полуходе хватает числа легальных ходов
+    if (depth == 1) return moves.size();
+
+    uint64_t nodes = 0;
+    if (hash && hash->probe(pos.getHash(), depth, nodes)) return nodes;
+
+    for (const Move& m : moves) {
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        nodes += perft(pos, depth - 1, hash);
+        pos.unmakeMove(m, undo);
+    }
+
+    if (hash) hash->store(pos.getHash(), depth, nodes);
+    return nodes;
+}
+
+PerftResult runPerft(const Position& root, int depth, const PerftOptions& opts, bool divide) {
+    using clock = std::chrono::steady_clock;
+    PerftResult res;
+    auto start = clock::now();
+
+    std::unique_ptr<PerftHash> hash;
+    if (opts.hashMB > 0) hash = std::make_unique<PerftHash>(opts.hashMB);
+
+    MoveList rootMoves = root.getLegalMoves();
+    std::vector<uint64_t> counts(rootMoves.size(), 0);
+
+    if (depth <= 1 || opts.threads <= 1) {
+        Position pos = root;
+        for (int i = 0; i < rootMoves.size(); ++i) {
+            UndoInfo undo;
+            pos.makeMove(rootMoves[i], undo);
+            counts[i] = perft(pos, depth - 1, hash.get());
+            pos.unmakeMove(rootMoves[i], undo);
+        }
+    } else {
+        // корневые ходы раздаются потокам по атомарному индексу
+        std::atomic<int> nextIdx{0};
+        {
+            ThreadPool pool(opts.threads);
+            for (int t = 0; t < opts.threads; ++t) {
+                pool.enqueue([&]() {
+                    Position local = root;
+                    for (int i = nextIdx.fetch_add(1); i < rootMoves.size(); i = nextIdx.fetch_add(1)) {
+                        UndoInfo undo;
+                        local.makeMove(rootMoves[i], undo);
+                        counts[i] = perft(local, depth - 1, hash.get());
+                        local.unmakeMove(rootMoves[i], undo);
+                    }
+                });
+            }
+            pool.shutdown();
+        }
+    }
+
+    for (int i = 0; i < rootMoves.size(); ++i) {
+        res.nodes += counts[i];
+        if (divide) res.divide.emplace_back(rootMoves[i], counts[i]);
+    }
+    if (depth <= 0) res.nodes = 1;
+
+    res.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return res;
+}
+
+void printPerft(const PerftResult& res, std::ostream& out) {
+    for (const auto& [m, n] : res.divide) {
+        out << encodeUCIMove(m) << ": " << n << "\n";
+    }
+    if (!res.divide.empty()) out << "\n";
+    out << "Nodes searched: " << res.nodes << "\n";
+    out << "Time (ms): " << int64_t(res.seconds * 1000) << "\n";
+    out << "Nodes/second: " << res.nps() << std::endl;
+}
+
+namespace {
+
+struct PerftCase {
+    const char* fen;
+    std::vector<uint64_t> counts; // counts[d - 1] = perft(d)
+};
+
+// опубликованные значения (chessprogramming wiki, "Perft Results")
+const PerftCase perftSuite[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     {20, 400, 8902, 197281, 4865609}},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603}},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292}},
+    {"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+     {6, 264, 9467, 422333, 15833292}},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487}},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594}},
+};
+
+} // namespace
+
+bool runPerftSuite(const PerftOptions& opts, std::ostream& out) {
+    bool allPassed = true;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+
+    // одна позиция на весь набор, как у "position" в UCI: decodeFEN поверх прошлой доски
+    Position pos;
+    for (const PerftCase& c : perftSuite) {
+        decodeFEN(c.fen, pos);
+        int depth = (int)c.counts.size();
+
+        PerftResult res = runPerft(pos, depth, opts);
+        bool ok = res.nodes == c.counts[depth - 1];
+        allPassed = allPassed && ok;
+        totalNodes += res.nodes;
+        totalSeconds += res.seconds;
+
+        out << (ok ? "ok   " : "FAIL ") << c.fen << " depth " << depth
+            << " nodes " << res.nodes << " expected " << c.counts[depth - 1]
+            << " nps " << res.nps() << "\n";
+    }
+
+    PerftResult total;
+    total.nodes = totalNodes;
+    total.seconds = totalSeconds;
+    out << (allPassed ? "perft suite passed" : "perft suite FAILED") << "\n";
+    printPerft(total, out);
+    return allPassed;
+}
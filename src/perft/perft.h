@@ -0,0 +1,58 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <atomic>
+#include <iosfwd>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "position/position.h"
+
+/* Shared perft cache keyed on the Zobrist hash. Entries hold
+   (key ^ data, data) with data = nodes << 8 | depth, so a torn
+   write from another thread simply fails the check. */
+class PerftHash {
+public:
+    explicit PerftHash(size_t sizeMB);
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+    std::vector<Entry> table;
+    size_t mask;
+};
+
+struct PerftOptions {
+    int threads = 1;    // root moves are split across a ThreadPool when > 1
+    size_t hashMB = 0;  // 0 = no perft hash
+};
+
+struct PerftResult {
+    uint64_t nodes = 0;
+    double seconds = 0;
+    /* per root move, filled only by divide */
+    std::vector<std::pair<Move, uint64_t>> divide;
+
+    uint64_t nps() const {
+        return seconds > 0 ? uint64_t(nodes / seconds) : nodes;
+    }
+};
+
+/* leaf nodes at `depth`, bulk-counted at the last ply */
+uint64_t perft(Position& pos, int depth, PerftHash* hash = nullptr);
+
+/* timed perft from the root; with divide = true also records per-move counts */
+PerftResult runPerft(const Position& root, int depth, const PerftOptions& opts, bool divide = false);
+
+/* prints "<move>: <nodes>" lines (for divide) and the summary with nodes/sec */
+void printPerft(const PerftResult& res, std::ostream& out);
+
+/* runs the built-in positions against published counts, true if all match */
+bool runPerftSuite(const PerftOptions& opts, std::ostream& out);
+
+#endif // PERFT_H
@@ -0,0 +1,42 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bitboard/attacks.h"
+#include "fen/fen.h"
+#include "perft/perft.h"
+#include "searching/zobrist.h"
+
+/*
+   shiny-perft                          built-in suite against published counts
+   shiny-perft <depth> [options]        perft of the start position
+   options: --fen "<fen>"  --divide  --threads N  --hash MB
+*/
+int main(int argc, char* argv[]) {
+    initZobrist();
+    initAttacks();
+
+    PerftOptions opts;
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    int depth = 0;
+    bool divide = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) fen = argv[++i];
+        else if (arg == "--divide") divide = true;
+        else if (arg == "--threads" && i + 1 < argc) opts.threads = std::atoi(argv[++i]);
+        else if (arg == "--hash" && i + 1 < argc) opts.hashMB = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--suite") depth = 0;
+        else depth = std::atoi(arg.c_str());
+    }
+
+    if (depth <= 0) {
+        return runPerftSuite(opts, std::cout) ? 0 : 1;
+    }
+
+    Position pos;
+    decodeFEN(fen, pos);
+    printPerft(runPerft(pos, depth, opts, divide), std::cout);
+    return 0;
+}
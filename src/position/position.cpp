@@ -1,5 +1,12 @@
 #include "position.h"
+#include "../bitboard/attacks.h"
+#include "../searching/zobrist.h"
+#include "../evaluation/psqt.h"
+#include "../evaluation/nnue.h"
+#include <algorithm>
+#include <cassert>
 #include <utility>
+#include <cstdlib>
 
 Piece::Piece() {
     type = EMPTY;
@@ -57,15 +64,12 @@ void Piece::setType(Figures figure) {
 }
 
 Position::Position() {
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            board[i][j] = Piece(EMPTY, false);
-        }
-    }
+    resetBoard();
 
-    this->squareEnPassant = std::make_pair<int, int>(-1, -1);
+    this->epSquare = -1;
     this->castleRights = 0;
     this->isWhiteMove = true; 
+    refreshHash();
 }
 
 Position::Position(
@@ -77,9 +81,11 @@ Position::Position(
     bool                           longBlackCastle,
     std::pair<int, int>            squareEnPassant
 ) {
+    resetBoard();
+
     for (int i = 0; i < 8; ++i) {
         for (int j = 0; j < 8; ++j) {
-            this->board[i][j] = board[i][j];
+            this->setPiece(i, j, board[i][j]);
         }
     }
 
@@ -89,149 +95,205 @@ Position::Position(
     castleRights |= (int)shortBlackCastle << 2;
     castleRights |= (int)longBlackCastle << 3;
 
-    this->squareEnPassant = squareEnPassant;
+    this->epSquare = -1;
+    if (squareEnPassant.first >= 0 && squareEnPassant.first < 8 && squareEnPassant.second >= 0 && squareEnPassant.second < 8) {
+        this->epSquare = makeSquare(squareEnPassant.first, squareEnPassant.second);
+    }
 
     this->isWhiteMove = isWhiteMove;
+    refreshHash();
+}
+
+void Position::resetBoard() {
+    byType.fill(0);
+    byColor.fill(0);
+    key = 0;
+    pawnKey = 0;
+
+    kingSq.fill(-1);
+    for (auto& c : pieceCounts) c.fill(0);
+    nonPawnMat.fill(0);
+    materialKey = 0;
+    psqMg = psqEg = 0;
+    phase = 0;
+}
+
+void Position::putPiece(int sq, int index, bool color) {
+    Bitboard b = squareBB(sq);
+    byType[index] |= b;
+    byColor[color] |= b;
+    key ^= zobristPiece(color, index, sq);
+
+    materialKey ^= zobristMaterialCount(color, index, pieceCounts[color][index]++);
+    int psq = color ? sq : sq ^ 56;
+    psqMg += color ? psq_mg[index][psq] : -psq_mg[index][psq];
+    psqEg += color ? psq_eg[index][psq] : -psq_eg[index][psq];
+    phase += phase_weight[index];
+    if (index == PAWN_IDX) pawnKey ^= zobristPiece(color, index, sq);
+    else if (index == KING_IDX) kingSq[color] = sq;
+    else nonPawnMat[color] += piece_value[index];
 }
 
-Position::~Position() {
+void Position::removePiece(int sq, int index, bool color) {
+    Bitboard b = squareBB(sq);
+    byType[index] &= ~b;
+    byColor[color] &= ~b;
+    key ^= zobristPiece(color, index, sq);
+
+    materialKey ^= zobristMaterialCount(color, index, --pieceCounts[color][index]);
+    int psq = color ? sq : sq ^ 56;
+    psqMg -= color ? psq_mg[index][psq] : -psq_mg[index][psq];
+    psqEg -= color ? psq_eg[index][psq] : -psq_eg[index][psq];
+    phase -= phase_weight[index];
+    if (index == PAWN_IDX) pawnKey ^= zobristPiece(color, index, sq);
+    else if (index == KING_IDX && kingSq[color] == sq) kingSq[color] = -1;
+    else nonPawnMat[color] -= piece_value[index];
+}
+
+void Position::movePiece(int from, int to, int index, bool color) {
+    Bitboard b = squareBB(from) | squareBB(to);
+    byType[index] ^= b;
+    byColor[color] ^= b;
+    key ^= zobristPiece(color, index, from) ^ zobristPiece(color, index, to);
+
+    int flip = color ? 0 : 56;
+    int dMg = psq_mg[index][to ^ flip] - psq_mg[index][from ^ flip];
+    int dEg = psq_eg[index][to ^ flip] - psq_eg[index][from ^ flip];
+    psqMg += color ? dMg : -dMg;
+    psqEg += color ? dEg : -dEg;
+
+    if (index == PAWN_IDX) pawnKey ^= zobristPiece(color, index, from) ^ zobristPiece(color, index, to);
+    else if (index == KING_IDX) kingSq[color] = to;
 }
 
 /* it changes original piece's position 
    x = 0, y = 0 is a1 */
 void Position::setPiece(int x, int y, Piece piece) {
-    board[x][y] = piece;
+    setPiece(x, y, piece.getType(), piece.isWhite());
 }
 
 /* x = 0, y = 0 is a1 */
 void Position::setPiece(int x, int y, Figures figure, bool color) {
-    board[x][y] = Piece(figure, color);
+    int sq = makeSquare(x, y);
+    Figures old = pieceTypeAt(sq);
+    if (old != EMPTY) {
+        removePiece(sq, pieceIndex(old), (byColor[WHITE] >> sq) & 1);
+    }
+    if (figure != EMPTY) {
+        putPiece(sq, pieceIndex(figure), color);
+    }
+}
+
+Bitboard Position::attackersTo(int sq, Bitboard occ) const {
+    Bitboard queens = byType[pieceIndex(QUEEN)];
+    return (pawnAttacks(BLACK, sq) & byType[pieceIndex(PAWN)] & byColor[WHITE])
+         | (pawnAttacks(WHITE, sq) & byType[pieceIndex(PAWN)] & byColor[BLACK])
+         | (knightAttacks(sq) & byType[pieceIndex(KNIGHT)])
+         | (kingAttacks(sq) & byType[pieceIndex(KING)])
+         | (bishopAttacks(sq, occ) & (byType[pieceIndex(BISHOP)] | queens))
+         | (rookAttacks(sq, occ) & (byType[pieceIndex(ROOK)] | queens));
 }
 
 bool Position::isSquareAttacked(const std::pair<int, int>& pos) const {
-    int x = pos.first;
-    int y = pos.second;
+    int sq = makeSquare(pos.first, pos.second);
     bool attackerColor = !isWhiteMove;
+    Bitboard them = byColor[attackerColor];
 
-    // Pawn
-    {
-        int dir = attackerColor ? 1 : -1; 
-        int px[2] = {x - 1, x + 1};
-        int py = y - dir;
-        for (int i = 0; i < 2; i++) {
-            int nx = px[i], ny = py;
-            if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
-                Piece p = getPiece(nx, ny);
-                if (p.getType() == PAWN && p.isWhite() == attackerColor)
-                    return true;
-            }
-        }
-    }
-
-    // Knight
-    {
-        const int knightMoves[8][2] = {
-            {1,2},{2,1},{-1,2},{-2,1},
-            {1,-2},{2,-1},{-1,-2},{-2,-1}
-        };
-        for (auto &m : knightMoves) {
-            int nx = x + m[0], ny = y + m[1];
-            if (nx>=0 && nx<8 && ny>=0 && ny<8) {
-                Piece p = getPiece(nx, ny);
-                if (p.getType() == KNIGHT && p.isWhite() == attackerColor)
-                    return true;
-            }
-        }
-    }
-
-    // King
-    {
-        const int kingMoves[8][2] = {
-            {1,0},{-1,0},{0,1},{0,-1},
-            {1,1},{1,-1},{-1,1},{-1,-1}
-        };
-        for (auto &m : kingMoves) {
-            int nx = x + m[0], ny = y + m[1];
-            if (nx>=0 && nx<8 && ny>=0 && ny<8) {
-                Piece p = getPiece(nx, ny);
-                if (p.getType() == KING && p.isWhite() == attackerColor)
-                    return true;
-            }
-        }
-    }
+    // пешка атакует sq, если пешка защищающейся стороны с sq била бы её
+    if (pawnAttacks(!attackerColor, sq) & byType[pieceIndex(PAWN)] & them) return true;
+    if (knightAttacks(sq) & byType[pieceIndex(KNIGHT)] & them) return true;
+    if (kingAttacks(sq) & byType[pieceIndex(KING)] & them) return true;
 
+    Bitboard queens = byType[pieceIndex(QUEEN)];
     // Diagonals(queen and bishop)
-    {
-        const int diagDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
-        for (auto &d : diagDirs) {
-            int nx = x + d[0], ny = y + d[1];
-            while (nx>=0 && nx<8 && ny>=0 && ny<8) {
-                Piece p = getPiece(nx, ny);
-                if (p.getType() != EMPTY) {
-                    if ((p.getType() == BISHOP || p.getType() == QUEEN) && p.isWhite() == attackerColor)
-                        return true;
-                    break;
-                }
-                nx += d[0];
-                ny += d[1];
-            }
-        }
-    }
-
+    if (bishopAttacks(sq, occupancy()) & (byType[pieceIndex(BISHOP)] | queens) & them) return true;
     // Straight(rook and queen)
-    {
-        const int lineDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
-        for (auto &d : lineDirs) {
-            int nx = x + d[0], ny = y + d[1];
-            while (nx>=0 && nx<8 && ny>=0 && ny<8) {
-                Piece p = getPiece(nx, ny);
-                if (p.getType() != EMPTY) {
-                    if ((p.getType() == ROOK || p.getType() == QUEEN) && p.isWhite() == attackerColor)
-                        return true;
-                    break;
-                }
-                nx += d[0];
-                ny += d[1];
-            }
-        }
-    }
+    if (rookAttacks(sq, occupancy()) & (byType[pieceIndex(ROOK)] | queens) & them) return true;
 
     return false;
 }
 
 bool Position::isCheck() const {
-    std::pair<int, int> kingPos(-1, -1);
+    int sq = kingSq[isWhiteMove];
+    if (sq < 0) {
+        return false; 
+    }
+
+    return attackersTo(sq, occupancy()) & byColor[!isWhiteMove];
+}
 
+bool Position::isInsufficientMaterial() const {
+    if (byType[pieceIndex(PAWN)] | byType[pieceIndex(ROOK)] | byType[pieceIndex(QUEEN)]) return false;
+    // без пешек и тяжёлых фигур: одна лёгкая фигура не может поставить мат
+    return nonPawnMat[WHITE] <= BISHOP && nonPawnMat[BLACK] <= BISHOP;
+}
 
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j].getType() == KING && this->isWhiteMove == board[i][j].isWhite()) {
-                kingPos.first = i;
-                kingPos.second = j;
+/* exchange values; the king outweighs everything so it never recaptures
+   onto a defended square */
+alignas(64) constexpr std::array<int, PIECE_IDX_NB> see_value = {100, 320, 330, 500, 900, 20000};
+
+int Position::see(const Move& m) const {
+    if (m.flag() == Move::CASTLING) return 0;
+
+    int from = m.from();
+    int to = m.to();
+    // пустое поле "откуда": хода нет, обмена тоже
+    PieceIndex attacker = pieceIndex(pieceTypeAt(from));
+    if (attacker == NO_PIECE_IDX) return 0;
+    Bitboard occ = occupancy();
+
+    // gain[d]: balance for the side making capture d if the sequence stops there
+    int gain[40];
+    int d = 0;
+    PieceIndex victim = m.isEnPassant() ? PAWN_IDX : pieceIndex(pieceTypeAt(to));
+    gain[0] = victim != NO_PIECE_IDX ? see_value[victim] : 0;
+    int attackerValue = see_value[attacker];
+    PieceIndex promotion = pieceIndex(m.promotion());
+    if (promotion != NO_PIECE_IDX) {
+        gain[0] += see_value[promotion] - see_value[PAWN_IDX];
+        attackerValue = see_value[promotion];
+    }
+    if (m.isEnPassant()) occ ^= squareBB(isWhiteMove ? to - 8 : to + 8);
+
+    Bitboard diagonal = byType[BISHOP_IDX] | byType[QUEEN_IDX];
+    Bitboard straight = byType[ROOK_IDX] | byType[QUEEN_IDX];
+    Bitboard attackers = attackersTo(to, occ) & occ;
+    Bitboard fromSet = squareBB(from);
+    bool side = isWhiteMove;
+
+    do {
+        ++d;
+        gain[d] = attackerValue - gain[d - 1];
+
+        // снять взявшую фигуру и открыть x-ray за ней
+        occ ^= fromSet;
+        attackers |= (bishopAttacks(to, occ) & diagonal) | (rookAttacks(to, occ) & straight);
+        attackers &= occ;
+
+        side = !side;
+        fromSet = 0;
+        Bitboard mine = attackers & byColor[side];
+        for (int i = PAWN_IDX; i <= KING_IDX; ++i) {
+            if (Bitboard b = mine & byType[i]) {
+                fromSet = b & -b;
+                attackerValue = see_value[i];
                 break;
             }
         }
-        if (kingPos.first != -1) {
-            break;
-        }
-    }
-
-    if (kingPos.first == -1) {
-        return false; 
-    }
+    } while (fromSet);
 
-    if (this->isSquareAttacked(kingPos)) {
-        return true;
-    }
-    return false;
+    while (--d) gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    return gain[0];
 }
 
 void Position::setIsWhiteMove(bool side) {
+    if (side != this->isWhiteMove) key ^= zobristSide;
     this->isWhiteMove = side;
 }
 
 void Position::setCastleRights(short castleRights) {
-    this->castleRights = castleRights;
+    key ^= zobristCastle[this->castleRights & 0xF] ^ zobristCastle[castleRights & 0xF];
+    this->castleRights = castleRights & 0xF;
 }
 
 short Position::getCastleRights() const {
@@ -243,11 +305,13 @@ bool Position::isWhiteToMove() const {
 }
 
 void Position::setEnPassant(int x, int y) {
+    if (epSquare != -1) key ^= zobristEnPassant[fileOf(epSquare)];
     if (x < 0 || x >= 8 || y < 0 || y >= 8) {
-        this->squareEnPassant = {-1, -1};
+        this->epSquare = -1;
         return;
     }
-    this->squareEnPassant = {x, y};
+    this->epSquare = makeSquare(x, y);
+    key ^= zobristEnPassant[x];
 }
 
 void Position::setEnPassant(std::pair<int, int> enPassant) {
@@ -255,284 +319,419 @@ void Position::setEnPassant(std::pair<int, int> enPassant) {
 }
 
 std::pair<int, int> Position::getEnPassant() const {
-    return this->squareEnPassant;
+    if (epSquare == -1) return {-1, -1};
+    return {fileOf(epSquare), rankOf(epSquare)};
+}
+
+void Position::refreshHash() {
+    key = computeHash(*this);
 }
 
 // --- локальные помощники ---
-static inline bool inBoard(int x, int y) { return x>=0 && x<8 && y>=0 && y<8; }
 
-static inline void add_promotion_or_push(std::vector<Move>& out, int fx,int fy,int tx,int ty, bool needPromo) {
+static inline void add_promotion_or_push(MoveList& out, int from, int to, bool needPromo) {
     if (!needPromo) {
-        out.push_back({fx,fy,tx,ty,EMPTY,false,false,false});
+        out.push_back(Move(from, to));
     } else {
         for (Figures pr : {QUEEN, ROOK, BISHOP, KNIGHT})
-            out.push_back({fx,fy,tx,ty,pr,false,false,false});
+            out.push_back(Move(from, to, Move::PROMOTION, pr));
+    }
+}
+
+void Position::applyMove(const Move& m) {
+    // ход мог прийти снаружи (UCI), пустую клетку не трогаем
+    if (m.isNone() || pieceTypeAt(m.from()) == EMPTY) return;
+
+    UndoInfo undo;
+    makeMove(m, undo);
+}
+
+// пересчёт psq-сумм с нуля, только для assert
+[[maybe_unused]] static bool psqConsistent(const Position& pos) {
+    int mg = 0, eg = 0, ph = 0;
+    for (int i = 0; i < 6; ++i) {
+        for (bool color : {true, false}) {
+            Bitboard b = pos.pieces(pieceByIndex[i], color);
+            while (b) {
+                int sq = popLsb(b);
+                int psq = color ? sq : sq ^ 56;
+                mg += color ? psq_mg[i][psq] : -psq_mg[i][psq];
+                eg += color ? psq_eg[i][psq] : -psq_eg[i][psq];
+                ph += phase_weight[i];
+            }
+        }
     }
+    return mg == pos.psqScoreMg() && eg == pos.psqScoreEg() && ph == pos.gamePhase();
 }
 
-// применить ход в копии позиции (минимально достаточно для проверки шаха)
-static void applyMove(Position& pos, const Move& m) {
-    bool moverIsWhite = pos.isWhiteToMove();
-    Piece moving = pos.getPiece(m.fromX, m.fromY);
+void Position::doMove(const Move& m, UndoInfo& undo) {
+    bool moverIsWhite = isWhiteMove;
+    int from = m.from();
+    int to = m.to();
+    Figures moving = pieceTypeAt(from);
 
-    // очистить начальную клетку
-    pos.setPiece(m.fromX, m.fromY, Piece(EMPTY, WHITE));
+    undo.captured = EMPTY;
+    undo.castleRights = castleRights;
+    undo.epSquare = epSquare;
+    undo.key = key;
+    short oldCastleRights = castleRights;
 
     // --- снять фигуру, если нужно (обычное взятие) ---
-    if (!(m.isEnPassant || m.isCastleShort || m.isCastleLong)) {
-        Piece target = pos.getPiece(m.toX, m.toY);
-        if (target.getType() != EMPTY) {
+    if (!(m.isEnPassant() || m.flag() == Move::CASTLING)) {
+        Figures target = pieceTypeAt(to);
+        if (target != EMPTY) {
+            bool targetIsWhite = !moverIsWhite;
+            undo.captured = target;
+            removePiece(to, pieceIndex(target), targetIsWhite);
             // если взяли ладью на угловом поле, снять права на рокировку
-            if (target.getType() == ROOK) {
-                if (target.isWhite()) {
-                    if (m.toX == 0 && m.toY == 0) pos.setCastleRights(pos.getCastleRights() & ~0b0010); // a1
-                    if (m.toX == 7 && m.toY == 0) pos.setCastleRights(pos.getCastleRights() & ~0b0001); // h1
+            if (target == ROOK) {
+                if (targetIsWhite) {
+                    if (to == makeSquare(0, 0)) castleRights &= ~0b0010; // a1
+                    if (to == makeSquare(7, 0)) castleRights &= ~0b0001; // h1
                 } else {
-                    if (m.toX == 0 && m.toY == 7) pos.setCastleRights(pos.getCastleRights() & ~0b1000); // a8
-                    if (m.toX == 7 && m.toY == 7) pos.setCastleRights(pos.getCastleRights() & ~0b0100); // h8
+                    if (to == makeSquare(0, 7)) castleRights &= ~0b1000; // a8
+                    if (to == makeSquare(7, 7)) castleRights &= ~0b0100; // h8
                 }
             }
         }
     }
 
     // --- специальные случаи ---
-    if (m.isEnPassant) {
+    if (m.isEnPassant()) {
         int dir = moverIsWhite ? 1 : -1;
-        pos.setPiece(m.toX, m.toY - dir, Piece(EMPTY, WHITE));
-    } else if (m.isCastleShort) {
+        undo.captured = PAWN;
+        removePiece(to - 8 * dir, pieceIndex(PAWN), !moverIsWhite);
+    } else if (m.isCastleShort()) {
         int y = moverIsWhite ? 0 : 7;
-        Piece rook = pos.getPiece(7, y);
-        pos.setPiece(7, y, Piece(EMPTY, WHITE));
-        pos.setPiece(5, y, rook);
-    } else if (m.isCastleLong) {
+        movePiece(makeSquare(7, y), makeSquare(5, y), pieceIndex(ROOK), moverIsWhite);
+    } else if (m.isCastleLong()) {
         int y = moverIsWhite ? 0 : 7;
-        Piece rook = pos.getPiece(0, y);
-        pos.setPiece(0, y, Piece(EMPTY, WHITE));
-        pos.setPiece(3, y, rook);
+        movePiece(makeSquare(0, y), makeSquare(3, y), pieceIndex(ROOK), moverIsWhite);
     }
 
     // --- поставить фигуру на целевую ---
-    if (m.promotion != EMPTY) moving.setType(m.promotion);
-    moving.setPos(m.toX, m.toY);
-    pos.setPiece(m.toX, m.toY, moving);
+    removePiece(from, pieceIndex(moving), moverIsWhite);
+    putPiece(to, pieceIndex(m.promotion() != EMPTY ? m.promotion() : moving), moverIsWhite);
 
     // --- обновить права на рокировку для своей стороны ---
-    if (moving.getType() == KING) {
+    if (moving == KING) {
         if (moverIsWhite) {
-            pos.setCastleRights(pos.getCastleRights() & ~0b0011); // убираем оба белых флага
+            castleRights &= ~0b0011; // убираем оба белых флага
         } else {
-            pos.setCastleRights(pos.getCastleRights() & ~0b1100); // убираем оба чёрных флага
+            castleRights &= ~0b1100; // убираем оба чёрных флага
         }
     }
-    if (moving.getType() == ROOK) {
+    if (moving == ROOK) {
         if (moverIsWhite) {
-            if (m.fromX == 0 && m.fromY == 0) pos.setCastleRights(pos.getCastleRights() & ~0b0010); // a1
-            if (m.fromX == 7 && m.fromY == 0) pos.setCastleRights(pos.getCastleRights() & ~0b0001); // h1
+            if (from == makeSquare(0, 0)) castleRights &= ~0b0010; // a1
+            if (from == makeSquare(7, 0)) castleRights &= ~0b0001; // h1
         } else {
-            if (m.fromX == 0 && m.fromY == 7) pos.setCastleRights(pos.getCastleRights() & ~0b1000); // a8
-            if (m.fromX == 7 && m.fromY == 7) pos.setCastleRights(pos.getCastleRights() & ~0b0100); // h8
+            if (from == makeSquare(0, 7)) castleRights &= ~0b1000; // a8
+            if (from == makeSquare(7, 7)) castleRights &= ~0b0100; // h8
         }
     }
 
+    if (castleRights != oldCastleRights) {
+        key ^= zobristCastle[oldCastleRights & 0xF] ^ zobristCastle[castleRights & 0xF];
+    }
+
     // --- обновить en passant ---
-    pos.setEnPassant(-1,-1);
-    if (moving.getType() == PAWN && std::abs(m.toY - m.fromY) == 2) {
-        int midRank = (m.toY + m.fromY) / 2;
-        pos.setEnPassant(m.fromX, midRank);
+    if (moving == PAWN && std::abs(to - from) == 16) {
+        setEnPassant(m.fromX(), (m.toY() + m.fromY()) / 2);
+    } else {
+        setEnPassant(-1, -1);
     }
 
     // --- переключить ход ---
-    pos.setIsWhiteMove(!moverIsWhite);
+    isWhiteMove = !moverIsWhite;
+    key ^= zobristSide;
+
+    assert(key == computeHash(*this));
+    assert(materialKey == computeMaterialKey(*this));
+    assert(pawnKey == computePawnKey(*this));
+    assert(psqConsistent(*this));
+}
+
+void Position::makeMove(const Move& m, UndoInfo& undo) {
+    doMove(m, undo);
+    if (nnue::active()) nnue::pushMove(*this, m, undo);
 }
 
-void Position::applyMove(const Move& move) {
-    ::applyMove(*this, move);
+Position Position::afterMove(const Move& m) const {
+    // копия уходит в другой поток: стек аккумуляторов этого потока не трогаем
+    Position child = *this;
+    UndoInfo undo;
+    child.doMove(m, undo);
+    return child;
 }
 
-// проверка: клетка (x,y) не атакована соперником цвета `attackerIsWhite`?
-static bool squareSafeFor(const Position& base, int x, int y, bool defenderIsWhite) {
-    Position tmp = base;
-    // isSquareAttacked берёт цвет атакующего как !isWhiteMove,
-    // значит isWhiteMove должен быть цветом защищающегося
-    tmp.setIsWhiteMove(defenderIsWhite);
-    return !tmp.isSquareAttacked({x,y});
+void Position::unmakeMove(const Move& m, const UndoInfo& undo) {
+    if (nnue::active()) nnue::popMove(key);
+
+    isWhiteMove = !isWhiteMove;
+    bool moverIsWhite = isWhiteMove;
+    int from = m.from();
+    int to = m.to();
+
+    // вернуть фигуру (превращённую — обратно в пешку)
+    Figures placed = pieceTypeAt(to);
+    removePiece(to, pieceIndex(placed), moverIsWhite);
+    putPiece(from, pieceIndex(m.promotion() != EMPTY ? PAWN : placed), moverIsWhite);
+
+    if (m.isEnPassant()) {
+        int dir = moverIsWhite ? 1 : -1;
+        putPiece(to - 8 * dir, pieceIndex(PAWN), !moverIsWhite);
+    } else if (m.isCastleShort()) {
+        int y = moverIsWhite ? 0 : 7;
+        movePiece(makeSquare(5, y), makeSquare(7, y), pieceIndex(ROOK), moverIsWhite);
+    } else if (m.isCastleLong()) {
+        int y = moverIsWhite ? 0 : 7;
+        movePiece(makeSquare(3, y), makeSquare(0, y), pieceIndex(ROOK), moverIsWhite);
+    } else if (undo.captured != EMPTY) {
+        putPiece(to, pieceIndex(undo.captured), !moverIsWhite);
+    }
+
+    castleRights = undo.castleRights;
+    epSquare = undo.epSquare;
+    key = undo.key;
 }
 
-// корректная рокировка с полными проверками
-static void genCastling(const Position& pos, bool side, int kx, int ky, std::vector<Move>& out) {
-    // король должен стоять на исходной клетке, но опираться будем на castleRights + пустые/неатакованные клетки
+// корректная рокировка с полными проверками (король не под шахом — проверено вызывающим)
+static void genCastling(const Position& pos, bool side, int ksq, MoveList& out) {
     short cr = pos.getCastleRights();
+    Bitboard occ = pos.occupancy();
+    Bitboard them = pos.piecesOf(!side);
+    int y = side ? 0 : 7;
 
-    // нельзя рокироваться если король сейчас под шахом
-    if (!squareSafeFor(pos, kx, ky, side)) return;
+    auto safe = [&](int x) {
+        return !(pos.attackersTo(makeSquare(x, y), occ) & them);
+    };
 
-    // short (king-side)
+    // short (king-side): f, g пустые и не атакованы
     if ((side && (cr & 0b0001)) || (!side && (cr & 0b0100))) {
-        int y = side ? 0 : 7;
-        // клетки между: f,g (5, y) и (6, y) пустые
-        if (pos.getPiece(5, y).getType() == EMPTY &&
-            pos.getPiece(6, y).getType() == EMPTY) {
-            // и не атакованы
-            if (squareSafeFor(pos, 5, y, side) && squareSafeFor(pos, 6, y, side)) {
-                out.push_back({kx, ky, 6, y, EMPTY, false, true, false});
-            }
+        if (!(occ & (squareBB(makeSquare(5, y)) | squareBB(makeSquare(6, y)))) && safe(5) && safe(6)) {
+            out.push_back(Move(ksq, makeSquare(6, y), Move::CASTLING));
         }
     }
-    // long (queen-side)
+    // long (queen-side): b, c, d пустые, c и d не атакованы
     if ((side && (cr & 0b0010)) || (!side && (cr & 0b1000))) {
-        int y = side ? 0 : 7;
-        // клетки между: b,c,d — (1,y) может быть занята ладьёй; обязательно пустые c,d (2,3)
-        if (pos.getPiece(1, y).getType() == EMPTY ||
-            pos.getPiece(1, y).getType() == ROOK) { /* допустим, но не обязательно пустая */ }
-        if (pos.getPiece(2, y).getType() == EMPTY &&
-            pos.getPiece(3, y).getType() == EMPTY) {
-            if (squareSafeFor(pos, 3, y, side) && squareSafeFor(pos, 2, y, side)) {
-                out.push_back({kx, ky, 2, y, EMPTY, false, false, true});
-            }
+        Bitboard path = squareBB(makeSquare(1, y)) | squareBB(makeSquare(2, y)) | squareBB(makeSquare(3, y));
+        if (!(occ & path) && safe(3) && safe(2)) {
+            out.push_back(Move(ksq, makeSquare(2, y), Move::CASTLING));
         }
     }
 }
 
-std::vector<Move> Position::getLegalMoves() const {
-    std::vector<Move> pseudo;
+/* Fully legal generator. Checkers, the check mask and pinned pieces are
+   computed once; only king moves and en passant are verified per move. */
+template <GenType type>
+void Position::generate(MoveList& moves) const {
+    constexpr bool captures = type != GEN_QUIETS;
+    constexpr bool quiets = type != GEN_CAPTURES;
+
     const bool white = isWhiteToMove();
+    const Bitboard us = byColor[white];
+    const Bitboard them = byColor[!white];
+    const Bitboard occupied = us | them;
 
-    for (int x = 0; x < 8; ++x) {
-        for (int y = 0; y < 8; ++y) {
-            Piece p = getPiece(x, y);
-            if (p.getType() == EMPTY) continue;
-            if (p.isWhite() != white) continue;
-
-            switch (p.getType()) {
-                case PAWN: {
-                    int dir = white ? 1 : -1;
-                    int startRank = white ? 1 : 6;
-                    int promoteRank = white ? 7 : 0;
-
-                    // вперед 1 (по Y)
-                    int fy = y + dir;
-                    if (inBoard(x, fy) && getPiece(x, fy).getType() == EMPTY) {
-                        if (fy == promoteRank) {
-                            for (Figures promo : {QUEEN, ROOK, BISHOP, KNIGHT})
-                                pseudo.push_back({x, y, x, fy, promo});
-                        } else {
-                            pseudo.push_back({x, y, x, fy, EMPTY});
-                        }
-
-                        // вперед 2 (только со старта и если промежуток пуст)
-                        int fy2 = y + 2 * dir;
-                        if (y == startRank && inBoard(x, fy2) &&
-                            getPiece(x, fy2).getType() == EMPTY && getPiece(x, fy).getType() == EMPTY) {
-                            pseudo.push_back({x, y, x, fy2, EMPTY});
-                        }
-                    }
+    const int ksq = kingSq[white];
+    if (ksq < 0) return;
+    const Bitboard king = squareBB(ksq);
 
-                    // взятия по диагонали
-                    for (int dx : {-1, 1}) {
-                        int nx = x + dx, ny = y + dir;
-                        if (!inBoard(nx, ny)) continue;
-                        Piece target = getPiece(nx, ny);
-                        if (target.getType() != EMPTY && target.isWhite() != white) {
-                            if (ny == promoteRank) {
-                                for (Figures promo : {QUEEN, ROOK, BISHOP, KNIGHT})
-                                    pseudo.push_back({x, y, nx, ny, promo});
-                            } else {
-                                pseudo.push_back({x, y, nx, ny, EMPTY});
-                            }
-                        }
-                    }
+    const Bitboard checkers = attackersTo(ksq, occupied) & them;
 
-                    // en-passant (если ep хранит координату клетки, на которую пойдет побившая пешка)
-                    auto ep = getEnPassant();
-                    if (ep.first != -1 && ep.second != -1) {
-                        int nx = ep.first, ny = ep.second;
-                        if (ny == y + dir && std::abs(nx - x) == 1) {
-                            Move m{x, y, nx, ny, EMPTY};
-                            m.isEnPassant = true;
-                            pseudo.push_back(m);
-                        }
-                    }
-                    break;
-                }
+    // связанные фигуры: между королём и вражеским дальнобойщиком ровно одна наша
+    Bitboard pinned = 0;
+    {
+        Bitboard queens = byType[pieceIndex(QUEEN)];
+        Bitboard snipers = ((rookAttacks(ksq, 0) & (byType[pieceIndex(ROOK)] | queens))
+                          | (bishopAttacks(ksq, 0) & (byType[pieceIndex(BISHOP)] | queens))) & them;
+        while (snipers) {
+            int s = popLsb(snipers);
+            Bitboard b = betweenBB(ksq, s) & occupied;
+            if (b && !(b & (b - 1)) && (b & us)) pinned |= b;
+        }
+    }
+
+    // при шахе ходы не-королём должны взять шахующую фигуру или закрыться
+    Bitboard checkMask = ~0ULL;
+    if (checkers) {
+        checkMask = (checkers & (checkers - 1)) ? 0 : betweenBB(ksq, lsb(checkers)) | checkers;
+    }
+
+    // клетки назначения для этой стадии
+    Bitboard stageTargets = 0;
+    if (captures) stageTargets |= them;
+    if (quiets) stageTargets |= ~occupied;
+
+    const Bitboard targets = stageTargets & checkMask;
+    const int up = white ? 8 : -8;
+    const int startRank = white ? 1 : 6;
+    const int promoteRank = white ? 7 : 0;
+
+    Bitboard own = us;
+    while (own) {
+        int sq = popLsb(own);
+        Figures piece = pieceTypeAt(sq);
+
+        if (piece == KING) {
+            // король: проверяем клетку назначения без самого короля на доске
+            Bitboard attacks = kingAttacks(sq) & stageTargets & ~us;
+            while (attacks) {
+                int to = popLsb(attacks);
+                if (!(attackersTo(to, occupied ^ king) & them)) moves.push_back(Move(sq, to));
+            }
+            if (quiets && !checkers) genCastling(*this, white, sq, moves);
+            continue;
+        }
 
-                case KNIGHT: {
-                    static const int kdx[8] = {1,2,2,1,-1,-2,-2,-1};
-                    static const int kdy[8] = {2,1,-1,-2,-2,-1,1,2};
-                    for (int i = 0; i < 8; ++i) {
-                        int nx = x + kdx[i], ny = y + kdy[i];
-                        if (!inBoard(nx, ny)) continue;
-                        Piece t = getPiece(nx, ny);
-                        if (t.getType() == EMPTY || t.isWhite() != white)
-                            pseudo.push_back({x, y, nx, ny, EMPTY});
+        // при двойном шахе ходит только король
+        if (!checkMask) continue;
+
+        Bitboard pinMask = (pinned & squareBB(sq)) ? lineBB(ksq, sq) : ~0ULL;
+
+        switch (piece) {
+            case PAWN: {
+                Bitboard allowed = checkMask & pinMask;
+
+                // вперед 1 (по Y); превращения идут вместе со взятиями
+                int to = sq + up;
+                if (!(occupied & squareBB(to))) {
+                    bool promo = rankOf(to) == promoteRank;
+                    if ((promo ? captures : quiets) && (allowed & squareBB(to)))
+                        add_promotion_or_push(moves, sq, to, promo);
+
+                    // вперед 2 (только со старта и если промежуток пуст)
+                    int to2 = to + up;
+                    if (quiets && rankOf(sq) == startRank && !(occupied & squareBB(to2)) && (allowed & squareBB(to2))) {
+                        moves.push_back(Move(sq, to2));
                     }
-                    break;
                 }
 
-                case BISHOP:
-                case ROOK:
-                case QUEEN: {
-                    static const int dirs[8][2] = {
-                        {1,0},{-1,0},{0,1},{0,-1},
-                        {1,1},{1,-1},{-1,1},{-1,-1}
-                    };
-                    int i0 = 0, i1 = 8;
-                    if (p.getType() == ROOK) { i0 = 0; i1 = 4; }
-                    else if (p.getType() == BISHOP) { i0 = 4; i1 = 8; }
-                    for (int i = i0; i < i1; ++i) {
-                        int dx = dirs[i][0], dy = dirs[i][1];
-                        int nx = x + dx, ny = y + dy;
-                        while (inBoard(nx, ny)) {
-                            Piece t = getPiece(nx, ny);
-                            if (t.getType() == EMPTY) {
-                                pseudo.push_back({x, y, nx, ny, EMPTY});
-                            } else {
-                                if (t.isWhite() != white)
-                                    pseudo.push_back({x, y, nx, ny, EMPTY});
-                                break;
-                            }
-                            nx += dx; ny += dy;
-                        }
-                    }
-                    break;
+                if (!captures) break;
+
+                // взятия по диагонали
+                Bitboard attacks = pawnAttacks(white, sq) & them & allowed;
+                while (attacks) {
+                    int cap = popLsb(attacks);
+                    add_promotion_or_push(moves, sq, cap, rankOf(cap) == promoteRank);
                 }
 
-                case KING: {
-                    for (int dx = -1; dx <= 1; ++dx) {
-                        for (int dy = -1; dy <= 1; ++dy) {
-                            if (dx == 0 && dy == 0) continue;
-                            int nx = x + dx, ny = y + dy;
-                            if (!inBoard(nx, ny)) continue;
-                            Piece t = getPiece(nx, ny);
-                            if (t.getType() == EMPTY || t.isWhite() != white)
-                                pseudo.push_back({x, y, nx, ny, EMPTY});
-                        }
+                // en-passant: проверяем целиком, связка по горизонтали видна только после взятия
+                if (epSquare != -1) {
+                    int epSq = epSquare;
+                    if (pawnAttacks(white, sq) & squareBB(epSq)) {
+                        Bitboard capturedBB = squareBB(epSq - up);
+                        Bitboard occ = (occupied ^ squareBB(sq) ^ capturedBB) | squareBB(epSq);
+                        if (!(attackersTo(ksq, occ) & them & ~capturedBB))
+                            moves.push_back(Move(sq, epSq, Move::EN_PASSANT));
                     }
+                }
+                break;
+            }
 
-                    genCastling(*this, white, x, y, pseudo);
-                    break;
+            case KNIGHT:
+            case BISHOP:
+            case ROOK:
+            case QUEEN: {
+                Bitboard attacks = 0;
+                if (piece == KNIGHT) attacks = knightAttacks(sq);
+                else if (piece == BISHOP) attacks = bishopAttacks(sq, occupied);
+                else if (piece == ROOK) attacks = rookAttacks(sq, occupied);
+                else attacks = queenAttacks(sq, occupied);
+
+                attacks &= targets & pinMask;
+                while (attacks) {
+                    moves.push_back(Move(sq, popLsb(attacks)));
                 }
-                default: break;
-            } // switch
-        } // for y
-    } // for x
-
-    // Фильтрация: оставляем только ходы, которые НЕ оставляют короля под шахом
-    std::vector<Move> legal;
-    legal.reserve(pseudo.size());
-    for (const auto &m : pseudo) {
-        Position copy = *this;
-        bool moverWasWhite = copy.isWhiteToMove();
-
-        // применяем ход (applyMove у тебя уже переключает сторону внутри)
-        copy.applyMove(m);
-
-        // вернуть сторону к ходившему, чтобы isCheck проверял короля ходившего цвета
-        copy.setIsWhiteMove(moverWasWhite);
-        if (!copy.isCheck()) {
-            legal.push_back(m);
+                break;
+            }
+
+            default: break;
+        } // switch
+    } // for own pieces
+}
+
+MoveList Position::getLegalMoves() const {
+    MoveList moves;
+    generate<GEN_ALL>(moves);
+    return moves;
+}
+
+void Position::generateCaptures(MoveList& moves) const {
+    generate<GEN_CAPTURES>(moves);
+}
+
+void Position::generateQuiets(MoveList& moves) const {
+    generate<GEN_QUIETS>(moves);
+}
+
+void Position::generateEvasions(MoveList& moves) const {
+    generate<GEN_EVASIONS>(moves);
+}
+
+bool Position::isLegalMove(Move m) const {
+    if (m.isNone()) return false;
+
+    const bool white = isWhiteToMove();
+    const Bitboard us = byColor[white];
+    const Bitboard them = byColor[!white];
+    const int from = m.from(), to = m.to();
+    const Figures piece = pieceTypeAt(from);
+
+    if (!(us & squareBB(from)) || (us & squareBB(to))) return false;
+
+    const int ksq = kingSq[white];
+    if (ksq < 0) return false;
+
+    // рокировку проще сверить с генератором: максимум два хода
+    if (m.flag() == Move::CASTLING) {
+        if (piece != KING || (attackersTo(ksq, occupancy()) & them)) return false;
+        MoveList castles;
+        genCastling(*this, white, ksq, castles);
+        for (const Move& c : castles) {
+            if (c == m) return true;
         }
-        // (не нужно восстанавливать copy дальше — он временный)
+        return false;
     }
 
-    return legal;
-}
\ No newline at end of file
+    const int up = white ? 8 : -8;
+    const int promoteRank = white ? 7 : 0;
+    Bitboard captured = them & squareBB(to);
+
+    if (piece == PAWN) {
+        bool promo = rankOf(to) == promoteRank;
+        if ((m.flag() == Move::PROMOTION) != promo && !m.isEnPassant()) return false;
+
+        if (m.isEnPassant()) {
+            if (epSquare == -1 || to != epSquare) return false;
+            if (!(pawnAttacks(white, from) & squareBB(to))) return false;
+            captured = squareBB(to - up);
+        } else if (pawnAttacks(white, from) & squareBB(to)) {
+            if (!captured) return false;
+        } else if (to == from + up) {
+            if (occupancy() & squareBB(to)) return false;
+        } else if (to == from + 2 * up && rankOf(from) == (white ? 1 : 6)) {
+            if (occupancy() & (squareBB(to) | squareBB(from + up))) return false;
+        } else {
+            return false;
+        }
+    } else {
+        if (m.flag() != Move::NORMAL) return false;
+        Bitboard attacks = 0;
+        switch (piece) {
+            case KNIGHT: attacks = knightAttacks(from); break;
+            case BISHOP: attacks = bishopAttacks(from, occupancy()); break;
+            case ROOK:   attacks = rookAttacks(from, occupancy()); break;
+            case QUEEN:  attacks = queenAttacks(from, occupancy()); break;
+            case KING:   attacks = kingAttacks(from); break;
+            default: break;
+        }
+        if (!(attacks & squareBB(to))) return false;
+    }
+
+    // легальность: после хода наш король не должен быть атакован
+    Bitboard occ = ((occupancy() ^ squareBB(from)) & ~captured) | squareBB(to);
+    int kingSq = piece == KING ? to : ksq;
+    return !(attackersTo(kingSq, occ) & them & ~captured);
+}
@@ -4,7 +4,9 @@
 
 #include <utility>
 #include <array>
-#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include "../bitboard/bitboard.h"
 
 enum Figures {
     PAWN = 100,
@@ -18,13 +20,120 @@ enum Figures {
     BLACK = false
 };
 
-struct Move {
-    int fromX, fromY;
-    int toX, toY;
-    Figures promotion; // EMPTY if there is not promotion
-    bool isEnPassant = false;
-    bool isCastleShort = false;
-    bool isCastleLong  = false;
+/* dense 0..5 index of a piece type: Figures carries centipawn values and
+   cannot address an array, PieceIndex can (bitboards, psqt.h tables) */
+enum PieceIndex : int {
+    PAWN_IDX,
+    KNIGHT_IDX,
+    BISHOP_IDX,
+    ROOK_IDX,
+    QUEEN_IDX,
+    KING_IDX,
+    PIECE_IDX_NB,
+    NO_PIECE_IDX = -1
+};
+
+constexpr inline PieceIndex pieceIndex(Figures figure) {
+    switch (figure) {
+        case PAWN:   return PAWN_IDX;
+        case KNIGHT: return KNIGHT_IDX;
+        case BISHOP: return BISHOP_IDX;
+        case ROOK:   return ROOK_IDX;
+        case QUEEN:  return QUEEN_IDX;
+        case KING:   return KING_IDX;
+        default:     return NO_PIECE_IDX;
+    }
+}
+
+constexpr Figures pieceByIndex[PIECE_IDX_NB] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+
+/* move generator stages */
+enum GenType {
+    GEN_CAPTURES, // captures, en passant and every promotion
+    GEN_QUIETS,   // everything else, castling included
+    GEN_EVASIONS, // all legal moves while in check
+    GEN_ALL
+};
+
+/* 16-bit packed move
+   bits  0-5   from square (y * 8 + x)
+   bits  6-11  to square
+   bits 12-13  promotion piece: 0 knight, 1 bishop, 2 rook, 3 queen
+   bits 14-15  flag: normal, promotion, en passant, castling
+   castling is stored as the king's move (e1g1, e1c1) */
+class Move {
+    uint16_t data;
+public:
+    enum Flag : uint16_t {
+        NORMAL     = 0,
+        PROMOTION  = 1 << 14,
+        EN_PASSANT = 2 << 14,
+        CASTLING   = 3 << 14
+    };
+
+    /* Move() is the null move (a1a1), `Move m;` is left uninitialised */
+    Move() = default;
+    constexpr Move(int from, int to, Flag flag = NORMAL, Figures promotion = KNIGHT)
+        : data(uint16_t(from | (to << 6) | ((pieceIndex(promotion) - 1) << 12) | flag)) {}
+
+    constexpr int from() const { return data & 0x3F; }
+    constexpr int to() const { return (data >> 6) & 0x3F; }
+    constexpr Flag flag() const { return Flag(data & (3 << 14)); }
+
+    /* x = 0, y = 0 is a1 */
+    constexpr int fromX() const { return fileOf(from()); }
+    constexpr int fromY() const { return rankOf(from()); }
+    constexpr int toX() const { return fileOf(to()); }
+    constexpr int toY() const { return rankOf(to()); }
+
+    /* EMPTY if there is not promotion */
+    constexpr Figures promotion() const {
+        return flag() == PROMOTION ? pieceByIndex[((data >> 12) & 3) + 1] : EMPTY;
+    }
+    constexpr bool isEnPassant() const { return flag() == EN_PASSANT; }
+    constexpr bool isCastleShort() const { return flag() == CASTLING && to() > from(); }
+    constexpr bool isCastleLong() const { return flag() == CASTLING && to() < from(); }
+
+    constexpr bool isNone() const { return data == 0; }
+    constexpr uint16_t raw() const { return data; }
+    /* inverse of raw(), for moves coming back from a table */
+    static constexpr Move fromRaw(uint16_t raw) {
+        Move m{};
+        m.data = raw;
+        return m;
+    }
+    constexpr bool operator==(const Move& other) const { return data == other.data; }
+};
+
+static_assert(sizeof(Move) == 2);
+
+/* fixed-capacity move buffer living on the stack, no position has more than 218 moves */
+class MoveList {
+    Move moves[256];
+    int count = 0;
+public:
+    inline void push_back(Move m) { moves[count++] = m; }
+    inline int size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline void clear() { count = 0; }
+    /* drops everything from n on, n <= size() */
+    inline void resize(int n) { count = n; }
+
+    inline Move& operator[](int i) { return moves[i]; }
+    inline const Move& operator[](int i) const { return moves[i]; }
+
+    inline Move* begin() { return moves; }
+    inline Move* end() { return moves + count; }
+    inline const Move* begin() const { return moves; }
+    inline const Move* end() const { return moves + count; }
+};
+
+/* what makeMove() overwrites and unmakeMove() needs back, one record per ply */
+struct UndoInfo {
+    Figures captured; // EMPTY if the move took nothing
+    uint8_t castleRights;
+    int8_t epSquare;
+    uint64_t key;
 };
 
 class Piece {
@@ -72,18 +181,44 @@ public:
 };
 
 class Position {
-    /* first index for rows while second is for cols */
-    std::array<std::array<Piece, 8>, 8> board;
+    /* one set per piece type, indexed by pieceIndex() */
+    std::array<Bitboard, PIECE_IDX_NB> byType;
+    /* byColor[WHITE] and byColor[BLACK] */
+    std::array<Bitboard, 2> byColor;
 
-    bool isWhiteMove;
-    std::pair<int, int> squareEnPassant;
+    /* zobrist key, kept in sync by every mutator */
+    uint64_t key;
+    /* same piece keys over the pawns only, for the pawn hash */
+    uint64_t pawnKey;
+
+    /* cached by putPiece/removePiece/movePiece, never rescanned */
+    uint64_t materialKey;                              // depends only on the piece counts
+    std::array<int16_t, 2> nonPawnMat;                 // [color], knights..queens by Figures value
+    int16_t psqMg, psqEg;                              // sum of psq_mg / psq_eg, white minus black
+    std::array<std::array<uint8_t, PIECE_IDX_NB>, 2> pieceCounts; // [color][pieceIndex]
+    std::array<int8_t, 2> kingSq;                      // [color], -1 without a king
+    uint8_t phase;                                     // sum of phase_weight over the board
+
+    int8_t epSquare; // square behind a double push, -1 if none
     /* 
        0b0001 short white 
        0b0010 long white 
        0b0100 short black
        0b1000 long black
     */
-    short castleRights;
+    uint8_t castleRights;
+    bool isWhiteMove;
+
+    void resetBoard();
+
+    void putPiece(int sq, int index, bool color);
+    void removePiece(int sq, int index, bool color);
+    void movePiece(int from, int to, int index, bool color);
+    /* makeMove() without the NNUE hook */
+    void doMove(const Move& move, UndoInfo& undo);
+
+    template <GenType type>
+    void generate(MoveList& moves) const;
 public:
     Position();
     Position(
@@ -95,11 +230,36 @@ public:
         bool                           longBlackCastle,
         std::pair<int, int> squareEnPassant = {-1, -1}
     );
-    ~Position();
     
-    /* x = 0, y = 0 is a1 */
+    /* type of the piece on square sq (y * 8 + x), EMPTY if there is none */
+    inline Figures pieceTypeAt(int sq) const {
+        Bitboard b = squareBB(sq);
+        if (!(occupancy() & b)) return EMPTY;
+        for (int i = 0; i < 6; ++i) {
+            if (byType[i] & b) return pieceByIndex[i];
+        }
+        return EMPTY;
+    }
+
+    /* compatibility view over the bitboards
+       x = 0, y = 0 is a1 */
     inline Piece getPiece(int x, int y) const {
-        return board[x][y];
+        int sq = makeSquare(x, y);
+        return Piece(pieceTypeAt(sq), (byColor[WHITE] >> sq) & 1);
+    }
+
+    inline Bitboard pieces(Figures figure, bool color) const {
+        return byType[pieceIndex(figure)] & byColor[color];
+    }
+    inline Bitboard piecesByType(Figures figure) const {
+        return byType[pieceIndex(figure)];
+    }
+    inline Bitboard piecesOf(bool color) const {
+        return byColor[color];
+    }
+    /* not stored: one OR is cheaper than eight more bytes per copy */
+    inline Bitboard occupancy() const {
+        return byColor[WHITE] | byColor[BLACK];
     }
     
     /* it changes original piece's position 
@@ -108,6 +268,8 @@ public:
     /* x = 0, y = 0 is a1 */
     void setPiece(int x, int y, Figures figure, bool color);
 
+    /* pieces of both colours attacking sq, sliders see through nothing but occ */
+    Bitboard attackersTo(int sq, Bitboard occ) const;
     bool isSquareAttacked(const std::pair<int, int>& pos) const;
     bool isCheck() const;
 
@@ -132,12 +294,82 @@ public:
     void setEnPassant(std::pair<int, int> enPassant);
     void setEnPassant(int x, int y);
     std::pair<int, int> getEnPassant() const;
+    /* -1 if there is no en-passant square */
+    inline int enPassantSquare() const {
+        return epSquare;
+    }
 
-    std::vector<Move> getLegalMoves() const;
+    inline uint64_t getHash() const {
+        return key;
+    }
+    /* recomputes the key from scratch */
+    void refreshHash();
+
+    /* -1 when `color` has no king */
+    inline int kingSquare(bool color) const {
+        return kingSq[color];
+    }
+    inline int count(Figures figure, bool color) const {
+        return pieceCounts[color][pieceIndex(figure)];
+    }
+    /* knights, bishops, rooks and queens of `color` in centipawns */
+    inline int nonPawnMaterial(bool color) const {
+        return nonPawnMat[color];
+    }
+    inline uint64_t getMaterialKey() const {
+        return materialKey;
+    }
+    inline uint64_t getPawnKey() const {
+        return pawnKey;
+    }
+    /* material + piece-square score from white's side, see psqt.h */
+    inline int psqScoreMg() const {
+        return psqMg;
+    }
+    inline int psqScoreEg() const {
+        return psqEg;
+    }
+    /* not capped, can exceed PHASE_MAX after promotions */
+    inline int gamePhase() const {
+        return phase;
+    }
+
+    /* no pawns, rooks or queens and at most one minor piece per side */
+    bool isInsufficientMaterial() const;
+
+    MoveList getLegalMoves() const;
+
+    /* staged generators, all of them emit legal moves only */
+    void generateCaptures(MoveList& moves) const;
+    void generateQuiets(MoveList& moves) const;
+    /* only valid while isCheck() */
+    void generateEvasions(MoveList& moves) const;
+
+    /* cheap validity test for a move from elsewhere (TT, killers) without generating */
+    bool isLegalMove(Move m) const;
+
+    /* static exchange evaluation of m on its target square, in centipawns for
+       the mover: cheapest attacker first on both sides, x-rays included, pins
+       ignored. Negative means the capture loses material */
+    int see(const Move& m) const;
     
     void applyMove(const Move& move);
+
+    /* plays a move generated for this position and fills `undo`
+       so that unmakeMove(move, undo) restores the position exactly */
+    void makeMove(const Move& move, UndoInfo& undo);
+    void unmakeMove(const Move& move, const UndoInfo& undo);
+
+    /* copy after a legal move, for a task run on another thread: unlike
+       makeMove() it leaves this thread's NNUE accumulator stack alone */
+    Position afterMove(const Move& move) const;
 };
 
-static void applyMove(Position& pos, const Move& m);
+/* copied into every search task and per thread, so it has to stay a few
+   cache lines of plain data. 114 bytes of fields, 120 with padding: up to
+   14 more bytes of narrow fields fit under the 128-byte limit below, one
+   more 64-bit word already takes 8 of them */
+static_assert(std::is_trivially_copyable_v<Position>, "Position must be trivially copyable");
+static_assert(sizeof(Position) <= 128, "Position must fit in two cache lines");
 
 #endif // POSITION_H
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "movepick.h"
+#include "evaluation/psqt.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr int KILLER_DEPTHS = 128;
+constexpr int HISTORY_MAX = 16384;
+
+/* [depth][slot] and [color][from][to], see recordCutoff() */
+struct OrderingTables {
+    Move killers[KILLER_DEPTHS][2];
+    int16_t history[2][64][64];
+};
+
+// по таблице на слот потока поиска: переживают итерации и пулы, чистятся на ucinewgame
+std::mutex slotsMutex;
+std::vector<std::unique_ptr<OrderingTables>> slots;
+// потоки без слота (UCI, perft) пишут в свою
+thread_local OrderingTables unbound{};
+thread_local OrderingTables* ordering = &unbound;
+
+// evasions put captures ahead of any quiet move
+constexpr int CAPTURE_BONUS = 1 << 20;
+
+inline bool isQuiet(const Position& pos, Move m) {
+    return m.promotion() == EMPTY && !m.isEnPassant() && pos.pieceTypeAt(m.to()) == EMPTY;
+}
+
+/* MVV-LVA: the victim dominates, the cheaper attacker breaks ties */
+inline int mvvLva(const Position& pos, Move m) {
+    Figures victim = m.isEnPassant() ? PAWN : pos.pieceTypeAt(m.to());
+    int score = victim != EMPTY ? piece_value[pieceIndex(victim)] * 8 : 0;
+    if (m.promotion() != EMPTY) score += piece_value[pieceIndex(m.promotion())] * 8;
+    return score - pieceIndex(pos.pieceTypeAt(m.from()));
+}
+
+inline int historyOf(const Position& pos, Move m) {
+    return ordering->history[pos.isWhiteToMove()][m.from()][m.to()];
+}
+
+} // namespace
+
+void recordCutoff(const Position& pos, Move m, int depth) {
+    if (!isQuiet(pos, m)) return;
+
+    if (depth < KILLER_DEPTHS) {
+        Move* k = ordering->killers[depth];
+        if (k[0] != m) {
+            k[1] = k[0];
+            k[0] = m;
+        }
+    }
+
+    // "gravity": the bonus shrinks as the entry approaches HISTORY_MAX, so it never overflows
+    int bonus = std::min(depth * depth, 400);
+    int16_t& h = ordering->history[pos.isWhiteToMove()][m.from()][m.to()];
+    h = int16_t(h + bonus - h * bonus / HISTORY_MAX);
+}
+
+void bindMoveHistory(int slot) {
+    std::lock_guard<std::mutex> lk(slotsMutex);
+    if (slot >= int(slots.size())) slots.resize(slot + 1);
+    if (!slots[slot]) slots[slot] = std::make_unique<OrderingTables>();
+    ordering = slots[slot].get();
+}
+
+void clearMoveHistory() {
+    std::lock_guard<std::mutex> lk(slotsMutex);
+    for (auto& t : slots) {
+        if (t) std::memset(t.get(), 0, sizeof(OrderingTables));
+    }
+    std::memset(&unbound, 0, sizeof(unbound));
+}
+
+MovePicker::MovePicker(const Position& pos, Move ttMove, int depth)
+    : pos(pos), ttMove(ttMove), inCheck(pos.isCheck()), capturesOnly(false), stage(TT_MOVE) {
+    bool known = depth >= 0 && depth < KILLER_DEPTHS;
+    killers[0] = known ? ordering->killers[depth][0] : Move();
+    killers[1] = known ? ordering->killers[depth][1] : Move();
+}
+
+MovePicker::MovePicker(const Position& pos)
+    : pos(pos), ttMove(Move()), killers{Move(), Move()}, inCheck(pos.isCheck()), capturesOnly(true) {
+    stage = inCheck ? GEN_EVASION_MOVES : GEN_CAPTURE_MOVES;
+}
+
+void MovePicker::scoreCaptures() {
+    for (int i = 0; i < moves.size(); ++i) scores[i] = mvvLva(pos, moves[i]);
+}
+
+void MovePicker::scoreQuiets() {
+    for (int i = 0; i < moves.size(); ++i) scores[i] = historyOf(pos, moves[i]);
+}
+
+void MovePicker::scoreEvasions() {
+    for (int i = 0; i < moves.size(); ++i) {
+        Move m = moves[i];
+        scores[i] = isQuiet(pos, m) ? historyOf(pos, m) : CAPTURE_BONUS + mvvLva(pos, m);
+    }
+}
+
+Move MovePicker::pickBest() {
+    int best = cur;
+    for (int i = cur + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves[cur], moves[best]);
+    std::swap(scores[cur], scores[best]);
+    return moves[cur++];
+}
+
+bool MovePicker::isKiller(Move m) const {
+    return m == killers[0] || m == killers[1];
+}
+
+Move MovePicker::next() {
+    for (;;) {
+        switch (stage) {
+            case TT_MOVE:
+                stage = inCheck ? GEN_EVASION_MOVES : GEN_CAPTURE_MOVES;
+                if (pos.isLegalMove(ttMove)) return ttMove;
+                break;
+
+            case GEN_CAPTURE_MOVES:
+                moves.clear();
+                badCaptures.clear();
+                pos.generateCaptures(moves);
+                scoreCaptures();
+                cur = 0;
+                stage = CAPTURE_MOVES;
+                break;
+
+            case CAPTURE_MOVES:
+                while (cur < moves.size()) {
+                    Move m = pickBest();
+                    if (m == ttMove) continue;
+                    // SEE только для реально выданных взятий
+                    if (pos.see(m) < 0) {
+                        if (!capturesOnly) badCaptures.push_back(m);
+                        continue;
+                    }
+                    return m;
+                }
+                stage = capturesOnly ? DONE : KILLER_MOVES;
+                cur = 0;
+                break;
+
+            case KILLER_MOVES:
+                // killers come from sibling nodes: re-check legality and that they are still quiet
+                while (cur < 2) {
+                    Move m = killers[cur++];
+                    if (!m.isNone() && m != ttMove && isQuiet(pos, m) && pos.isLegalMove(m)) return m;
+                }
+                stage = GEN_QUIET_MOVES;
+                break;
+
+            case GEN_QUIET_MOVES:
+                moves.clear();
+                pos.generateQuiets(moves);
+                scoreQuiets();
+                cur = 0;
+                stage = QUIET_MOVES;
+                break;
+
+            case QUIET_MOVES:
+                while (cur < moves.size()) {
+                    Move m = pickBest();
+                    if (m != ttMove && !isKiller(m)) return m;
+                }
+                cur = 0;
+                stage = BAD_CAPTURE_MOVES;
+                break;
+
+            case BAD_CAPTURE_MOVES:
+                while (cur < badCaptures.size()) {
+                    Move m = badCaptures[cur++];
+                    if (m != ttMove) return m;
+                }
+                stage = DONE;
+                break;
+
+            case GEN_EVASION_MOVES:
+                moves.clear();
+                pos.generateEvasions(moves);
+                scoreEvasions();
+                cur = 0;
+                stage = EVASION_MOVES;
+                break;
+
+            case EVASION_MOVES:
+                while (cur < moves.size()) {
+                    Move m = pickBest();
+                    if (m != ttMove) return m;
+                }
+                stage = DONE;
+                break;
+
+            default:
+                return Move();
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "position/position.h"
+
+/* Staged move picker. The TT move is validated and returned before anything
+   is generated, so a cutoff on it costs no move generation at all. Then
+   captures (MVV-LVA), killers and quiet moves (history) are generated on
+   demand; in check every stage is replaced by the evasion generator.
+   Each move is scored once and handed out by partial selection: only as
+   much of the list is ordered as the node actually consumes.
+   Captures with a negative SEE come after the quiets in the main search
+   and are dropped altogether in quiescence. */
+class MovePicker {
+public:
+    // main search: TT move, captures, killers, quiets; depth selects the killers
+    MovePicker(const Position& pos, Move ttMove, int depth);
+    // quiescence: non-losing captures only (every evasion when in check)
+    explicit MovePicker(const Position& pos);
+
+    // Move() when there is nothing left
+    Move next();
+
+private:
+    enum Stage {
+        TT_MOVE,
+        GEN_CAPTURE_MOVES, CAPTURE_MOVES,
+        KILLER_MOVES,
+        GEN_QUIET_MOVES, QUIET_MOVES,
+        BAD_CAPTURE_MOVES,
+        GEN_EVASION_MOVES, EVASION_MOVES,
+        DONE
+    };
+
+    const Position& pos;
+    Move ttMove;
+    Move killers[2];
+    bool inCheck;
+    bool capturesOnly;
+    int stage;
+
+    MoveList moves;
+    int scores[256];
+    int cur = 0;
+    /* SEE < 0, kept in the order they were picked */
+    MoveList badCaptures;
+
+    void scoreCaptures();
+    void scoreQuiets();
+    void scoreEvasions();
+    // moves the best remaining move to cur and returns it
+    Move pickBest();
+    bool isKiller(Move m) const;
+};
+
+/* Killers (two per remaining depth) and butterfly history of the calling
+   thread; only quiet moves are recorded. Pool threads live for one
+   iteration, so the tables belong to search thread slots instead: a worker
+   binds its slot before searching and finds what the same slot learnt in
+   earlier iterations and earlier searches. Unbound threads use a private
+   table. clearMoveHistory() empties every slot (ucinewgame) and must not
+   run during a search. */
+void recordCutoff(const Position& pos, Move m, int depth);
+void bindMoveHistory(int slot);
+void clearMoveHistory();
+
+#endif // MOVEPICK_H
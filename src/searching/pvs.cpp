@@ -2,59 +2,76 @@
 #include "pvs.h"
 #include "evaluation/evaluation.h"
 #include "position/position.h"
-#include <algorithm>
+#include "movepick.h"
 
 constexpr int INF = 1000000000; // безопасная "бесконечность"
 
-constexpr inline int pieceValue(Figures figure) {
-    return figure;
-}
-
 // Quiescence: assume evaluate(...) already returns negamax-convention (score from side to move)
-int quiescence(Position& pos, int alpha, int beta) {
-    int standPat = evaluate(pos);
+// Results go to the TT at depth 0, together with the static eval, so a
+// transposition gets its stand-pat (or a cutoff) without evaluate().
+int quiescence(Position& pos, int alpha, int beta, TranspositionTable& tt) {
+    uint64_t key = pos.getHash();
+    int alphaOrig = alpha;
+
+    int ttScore = 0, staticEval = EVAL_NONE;
+    Move ttMove = Move();
+    if (tt.probe(key, 0, alpha, beta, ttScore, ttMove, staticEval)) return ttScore;
+
+    // далеко за окном хватает материала + PST; такая оценка не точная и в TT не идёт
+    int standPat = staticEval;
+    if (standPat == EVAL_NONE) {
+        bool lazy;
+        standPat = evaluate(pos, alpha, beta, lazy);
+        if (!lazy) staticEval = standPat;
+    }
     // standPat уже в конвенции стороны на ходу
-    if (standPat >= beta) return beta;
+    if (standPat >= beta) {
+        tt.store(key, 0, beta, BoundType::LOWER, Move(), staticEval);
+        return beta;
+    }
     if (standPat > alpha) alpha = standPat;
 
-    std::vector<Move> moves = pos.getLegalMoves();
-    bool inCheck = pos.isCheck();
-
-    // simple ordering: captures first
-    std::stable_sort(moves.begin(), moves.end(), [&](const Move& a, const Move& b){
-        Piece ta = pos.getPiece(a.toX, a.toY);
-        Piece tb = pos.getPiece(b.toX, b.toY);
-        int va = (ta.getType()==EMPTY && !a.isEnPassant) ? 0 : pieceValue(ta.getType());
-        int vb = (tb.getType()==EMPTY && !b.isEnPassant) ? 0 : pieceValue(tb.getType());
-        return va > vb;
-    });
-
-    for (const auto& m : moves) {
-        Piece trg = pos.getPiece(m.toX, m.toY);
-        bool isCap = (trg.getType() != EMPTY) || m.isEnPassant;
-        if (!inCheck && !isCap) continue;
-
-        Position child = pos;
-        child.applyMove(m);
-        int score = -quiescence(child, -beta, -alpha);
-        if (score >= beta) return beta;
-        if (score > alpha) alpha = score;
+    // only captures and promotions (all evasions when in check), best victim first
+    MovePicker picker(pos);
+    Move bestMove = Move();
+    Move m;
+    while (!(m = picker.next()).isNone()) {
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        tt.prefetch(pos.getHash());
+        int score = -quiescence(pos, -beta, -alpha, tt);
+        pos.unmakeMove(m, undo);
+        if (score >= beta) {
+            tt.store(key, 0, beta, BoundType::LOWER, m, staticEval);
+            return beta;
+        }
+        if (score > alpha) {
+            alpha = score;
+            bestMove = m;
+        }
     }
+    tt.store(key, 0, alpha, alpha > alphaOrig ? BoundType::EXACT : BoundType::UPPER, bestMove, staticEval);
     return alpha;
 }
 
 // PVS (negamax-style)
 SearchResult pvs(Position& pos, int depth, int alpha, int beta, bool /*unused*/, TranspositionTable& tt) {
     SearchResult result{};
-    result.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    result.bestMove = Move();
     result.depth = depth;
 
-    uint64_t key = computeHash(pos);
+    // ничья по материалу: искать дальше нечего
+    if (pos.isInsufficientMaterial()) {
+        result.score = 0;
+        return result;
+    }
+
+    uint64_t key = pos.getHash();
     int alphaOrig = alpha;
 
     // TT probe (may provide ordering move even if not usable)
     int ttScore = 0;
-    Move ttMove = Move{-1,-1,-1,-1, EMPTY};
+    Move ttMove = Move();
     if (tt.probe(key, depth, alpha, beta, ttScore, ttMove)) {
         result.score = ttScore;
         result.bestMove = ttMove;
@@ -63,65 +80,59 @@ SearchResult pvs(Position& pos, int depth, int alpha, int beta, bool /*unused*/,
 
     // leaf
     if (depth <= 0) {
-        result.score = quiescence(pos, alpha, beta);
-        return result;
-    }
-
-    std::vector<Move> moves = pos.getLegalMoves();
-    if (moves.empty()) {
-        if (pos.isCheck()) {
-            result.score = -INF + depth; // mate for side to move
-        } else {
-            result.score = 0; // stalemate
-        }
+        result.score = quiescence(pos, alpha, beta, tt);
         return result;
     }
 
-    // move ordering: put TT move first if present
-    if (ttMove.fromX != -1) {
-        auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m){
-            return m.fromX==ttMove.fromX && m.fromY==ttMove.fromY && m.toX==ttMove.toX && m.toY==ttMove.toY && m.promotion==ttMove.promotion;
-        });
-        if (it != moves.end()) std::iter_swap(moves.begin(), it);
-    }
-
-    // simple ordering: captures next
-    std::stable_sort(moves.begin()+1, moves.end(), [&](const Move& a, const Move& b){
-        Piece ta = pos.getPiece(a.toX, a.toY);
-        Piece tb = pos.getPiece(b.toX, b.toY);
-        int va = (ta.getType()==EMPTY && !a.isEnPassant) ? 0 : pieceValue(ta.getType());
-        int vb = (tb.getType()==EMPTY && !b.isEnPassant) ? 0 : pieceValue(tb.getType());
-        return va > vb;
-    });
+    // staged ordering: TT move (before any generation), captures, killers, quiets
+    MovePicker picker(pos, ttMove, depth);
 
     int bestScore = -INF;
-    Move bestMove = Move{-1,-1,-1,-1, EMPTY};
+    Move bestMove = Move();
     bool first = true;
+    int moveCount = 0;
 
-    for (const auto& m : moves) {
-        Position child = pos;
-        child.applyMove(m);
+    Move m;
+    while (!(m = picker.next()).isNone()) {
+        ++moveCount;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        // ключ ребёнка уже готов: кластер грузится, пока идём до probe
+        tt.prefetch(pos.getHash());
 
         int val;
         if (first) {
-            SearchResult sr = pvs(child, depth - 1, -beta, -alpha, false, tt);
+            SearchResult sr = pvs(pos, depth - 1, -beta, -alpha, false, tt);
             val = -sr.score;
             first = false;
         } else {
-            SearchResult sr = pvs(child, depth - 1, -alpha - 1, -alpha, false, tt);
+            SearchResult sr = pvs(pos, depth - 1, -alpha - 1, -alpha, false, tt);
             val = -sr.score;
             if (val > alpha && val < beta) {
-                SearchResult sr2 = pvs(child, depth - 1, -beta, -alpha, false, tt);
+                SearchResult sr2 = pvs(pos, depth - 1, -beta, -alpha, false, tt);
                 val = -sr2.score;
             }
         }
+        pos.unmakeMove(m, undo);
 
         if (val > bestScore) {
             bestScore = val;
             bestMove = m;
         }
         if (bestScore > alpha) alpha = bestScore;
-        if (alpha >= beta) break; // beta cutoff
+        if (alpha >= beta) {
+            recordCutoff(pos, m, depth); // killers and history, quiet moves only
+            break;
+        }
+    }
+
+    if (moveCount == 0) {
+        if (pos.isCheck()) {
+            result.score = -INF + depth; // mate for side to move
+        } else {
+            result.score = 0; // stalemate
+        }
+        return result;
     }
 
     result.score = bestScore;
@@ -2,7 +2,9 @@
 #define PVS_H
 
 #include "position/position.h"
-#include <shared_mutex>
+#include <atomic>
+#include <vector>
+#include "tt_memory.h"
 
 struct SearchResult {
     int score;
@@ -11,43 +13,107 @@ struct SearchResult {
 };
 
 #include <cstdint>
-
-// zobrist keys
-extern uint64_t zobristTable[2][6][8][8]; // [color][pieceType][file][rank]
-extern uint64_t zobristSide;              // чей ход
-extern uint64_t zobristCastle[16];        // рокировочные права
-extern uint64_t zobristEnPassant[8];      // файл взятия на проходе
-
-void initZobrist();
-uint64_t computeHash(const Position& pos);
+#include "zobrist.h"
 
 // тип записи в TT
 enum class BoundType { EXACT, LOWER, UPPER };
 
+/* static eval not known; evals are stored as int16 */
+constexpr int EVAL_NONE = -32768;
+
+/* unpacked view of a slot */
 struct TTEntry {
     uint64_t key;
     int depth;
     int score;
     BoundType bound;
     Move bestMove;
+    int eval;  // static eval of the position, EVAL_NONE if not stored
 };
 
 // сама таблица
 
+/* Lock-free: a slot holds (key ^ data, data) in two relaxed atomics, where
+   data packs move, depth, bound, generation and score. The low 16 bits of
+   the check word carry the static eval instead of key bits. A slot torn by
+   concurrent stores fails the XOR check on the other 112 bits and reads as
+   a miss, so nobody ever waits. Slots are grouped four to a 64-byte cluster, so a probe
+   touches exactly one cache line. Storage is a TTMemory mapping, an
+   all-zero cluster is empty. */
 class TranspositionTable {
 public:
     explicit TranspositionTable(size_t sizeMB = 64);
     bool probe(uint64_t key, int depth, int alpha, int beta, int& score, Move& best);
-    void store(uint64_t key, int depth, int score, BoundType bound, const Move& best);
+    /* same, and hands out the stored static eval (EVAL_NONE if none) even without a cutoff */
+    bool probe(uint64_t key, int depth, int alpha, int beta, int& score, Move& best, int& staticEval);
+    /* staticEval = EVAL_NONE keeps whatever eval the slot had for this key */
+    void store(uint64_t key, int depth, int score, BoundType bound, const Move& best, int staticEval = EVAL_NONE);
 
+    /* pulls the cluster of `key` towards L1, issue it as soon as a child key is known */
+    inline void prefetch(uint64_t key) const {
+        __builtin_prefetch(&clusterFor(key));
+    }
+
+    /* ages every entry by one search, call once per `go` */
+    void newSearch();
     void clear();
+    /* drops the contents; the new mapping is zeroed lazily by the kernel */
+    void resize(size_t sizeMB);
+
+    /* switches to the named shared segment (see TTMemory::shared), keeping
+       its contents; false (table untouched) if it cannot be mapped */
+    bool attachShared(const std::string& name);
+    inline bool isShared() const {
+        return memory.kind() == TTMemory::Kind::SHARED;
+    }
+
+    /* dumps header + clusters to `path`, false on I/O errors */
+    bool save(const std::string& path) const;
+    /* maps a file written by save() in place of the current table; false
+       (table untouched) if it is missing or has another layout or seed */
+    bool load(const std::string& path);
+
+    inline size_t sizeInMB() const {
+        return sizeMB;
+    }
 private:
-    std::vector<TTEntry> table;
-    mutable std::shared_mutex tableMutex;
-    size_t sizeMB;
+    /* plain words accessed through std::atomic_ref so that raw mapped
+       memory is a valid table */
+    struct Slot {
+        uint64_t check;
+        uint64_t data;
+    };
+
+    static constexpr int CLUSTER_SIZE = 4;
+    struct alignas(64) Cluster {
+        Slot slots[CLUSTER_SIZE];
+    };
+    static_assert(sizeof(Cluster) == 64, "one cluster per cache line");
+
+    /* generation lives in 6 bits, bound + 1 in the 2 below it, so the data
+       word of an occupied slot is never 0 */
+    static constexpr int GENERATION_CYCLE = 64;
+
+    static uint64_t pack(const TTEntry& e, uint8_t generation);
+    static TTEntry unpack(uint64_t key, uint64_t data, uint64_t check);
+    static uint8_t generationOf(uint64_t data);
+    /* false if the slot does not hold `key` (or was torn) */
+    bool read(const Slot& s, uint64_t key, TTEntry& out) const;
+
+    /* multiply-shift: high half of key * clusters, no modulo and no
+       power-of-two restriction on the size */
+    inline Cluster& clusterFor(uint64_t key) const {
+        return table[size_t((unsigned __int128)key * clusterCount >> 64)];
+    }
+
+    TTMemory memory;
+    Cluster* table = nullptr;
+    size_t clusterCount = 0;
+    size_t sizeMB = 0;
+    uint8_t generation = 0;
 };
 
-int quiescence(Position& pos, int alpha, int beta);
+int quiescence(Position& pos, int alpha, int beta, TranspositionTable& tt);
 SearchResult pvs(Position& pos, int depth, int alpha, int beta, bool maximizingPlayer, TranspositionTable& tt);
 
 #endif // PVS_H
\ No newline at end of file
@@ -6,35 +6,59 @@
 #include <chrono>
 #include "../threading/pvs_mt.h"
 #include "../position/position.h"
+#include "searching.h"
+#include "movepick.h"
+#include "../evaluation/pawns.h"
 
 // Константы
 constexpr int INF_SEARCH = 1000000000;
 
+// корневые ходы: только легальные из доли процесса, если она задана
+static MoveList restrictRoot(const MoveList& legal, const MoveList* rootShare) {
+    if (!rootShare) return legal;
+    MoveList res;
+    for (const Move& m : legal) {
+        for (const Move& s : *rootShare) {
+            if (s == m) {
+                res.push_back(m);
+                break;
+            }
+        }
+    }
+    return res;
+}
+
 // ---------- root-parallel по глубине, фиксированное число потоков ----------
-SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, TranspositionTable& tt, int numThreads) {
+SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, TranspositionTable& tt, int numThreads,
+                                            const MoveList* rootShare, const IterationCallback& onIteration) {
     SearchResult globalBest{};
     globalBest.depth = 0;
     globalBest.score = 0;
-    globalBest.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    globalBest.bestMove = Move();
 
     // защитные значения
     int hw = std::max(1u, std::thread::hardware_concurrency());
     int nThreads = std::max(1, std::min(numThreads, (int)hw));
 
+    // лимита по времени нет
+    search_control::clearDeadline();
+
     // для каждой глубины запускаем распределение корневых ходов на nThreads
     for (int depth = 1; depth <= maxDepth; ++depth) {
         if (search_control::shouldStop()) break;
 
-        std::vector<Move> rootMoves = pos.getLegalMoves();
+        MoveList rootMoves = pos.getLegalMoves();
         if (rootMoves.empty()) {
             // мат/пат
             if (pos.isCheck()) { globalBest.score = -INF_SEARCH + depth; }
             else { globalBest.score = 0; }
             return globalBest;
         }
+        rootMoves = restrictRoot(rootMoves, rootShare);
+        if (rootMoves.empty()) return globalBest;
 
         // контейнеры для результатов
-        size_t M = rootMoves.size();
+        size_t M = (size_t)rootMoves.size();
         std::vector<SearchResult> results(M);
         std::atomic<size_t> nextIdx{0};
 
@@ -42,17 +66,22 @@ SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, Transpo
         ThreadPool pool(nThreads);
 
         // worker: берёт индекс и обрабатывает соответствующий root move
-        auto worker = [&](void) {
+        auto worker = [&](int t) {
+            // killers/history и пешечный хэш слота t остаются с прошлых итераций
+            bindMoveHistory(t);
+            bindPawnTable(t);
+            // своя копия корня на поток, дальше только make/unmake
+            Position local = pos;
             while (!search_control::shouldStop()) {
                 size_t i = nextIdx.fetch_add(1);
                 if (i >= M) break;
-                // подготовка child
-                Position child = pos;
-                child.applyMove(rootMoves[i]);
+                UndoInfo undo;
+                local.makeMove(rootMoves[i], undo);
 
                 // делаем синхронный поиск на child (depth-1). Используем pvs (thread-safe)
                 // вызываем с широким окном: -INF..INF
-                SearchResult r = pvs(child, depth - 1, -INF_SEARCH, INF_SEARCH, false, tt);
+                SearchResult r = pvs(local, depth - 1, -INF_SEARCH, INF_SEARCH, false, tt);
+                local.unmakeMove(rootMoves[i], undo);
                 // сохраняем
                 results[i] = r;
             }
@@ -60,7 +89,7 @@ SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, Transpo
 
         // запустить nThreads воркеров (enqueue nThreads задач, каждый цикл берёт столько задач, сколько нужно)
         for (int t = 0; t < nThreads; ++t) {
-            pool.enqueue([worker](){ worker(); });
+            pool.enqueue([worker, t](){ worker(t); });
         }
 
         // ждать пока все задачи будут выполнены или стоп
@@ -92,18 +121,20 @@ SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, Transpo
         globalBest.score = bestScore;
         globalBest.bestMove = bestMove;
         globalBest.depth = depth;
+        if (onIteration) onIteration(globalBest);
     }
 
     return globalBest;
 }
 
 // ---------- root-parallel по времени, фиксированное число потоков ----------
-SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, TranspositionTable& tt, int numThreads) {
+SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, TranspositionTable& tt, int numThreads,
+                                           const MoveList* rootShare, const IterationCallback& onIteration) {
     using clock_t = search_control::clock_t;
     SearchResult globalBest{};
     globalBest.depth = 0;
     globalBest.score = 0;
-    globalBest.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    globalBest.bestMove = Move();
 
     // защита параметров
     int hw = std::max(1u, std::thread::hardware_concurrency());
@@ -114,14 +145,16 @@ SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, Transp
 
     int depth = 1;
     while (!search_control::shouldStop()) {
-        std::vector<Move> rootMoves = pos.getLegalMoves();
+        MoveList rootMoves = pos.getLegalMoves();
         if (rootMoves.empty()) {
             if (pos.isCheck()) { globalBest.score = -INF_SEARCH + depth; }
             else { globalBest.score = 0; }
             return globalBest;
         }
+        rootMoves = restrictRoot(rootMoves, rootShare);
+        if (rootMoves.empty()) return globalBest;
 
-        size_t M = rootMoves.size();
+        size_t M = (size_t)rootMoves.size();
         std::vector<std::atomic<bool>> done(M);
         for (auto &b : done) b.store(false);
         std::vector<SearchResult> results(M);
@@ -134,14 +167,18 @@ SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, Transp
 
         // submit worker tasks (each task will take indices until none left)
         for (int t = 0; t < nThreads; ++t) {
-            pool.enqueue([&]() {
+            pool.enqueue([&, t]() {
+                bindMoveHistory(t);
+                bindPawnTable(t);
+                Position local = pos;
                 while (!search_control::shouldStop()) {
                     size_t i = nextIdx.fetch_add(1);
                     if (i >= M) break;
-                    Position child = pos;
-                    child.applyMove(rootMoves[i]);
+                    UndoInfo undo;
+                    local.makeMove(rootMoves[i], undo);
 
-                    SearchResult r = pvs(child, depth - 1, -INF_SEARCH, INF_SEARCH, false, tt);
+                    SearchResult r = pvs(local, depth - 1, -INF_SEARCH, INF_SEARCH, false, tt);
+                    local.unmakeMove(rootMoves[i], undo);
                     results[i] = r;
                     done[i].store(true);
                     remaining.fetch_sub(1);
@@ -170,7 +207,19 @@ SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, Transp
         pool.shutdown();
 
         if (!depthCompleted) {
-            // не принимаем неполную глубину
+            // не принимаем неполную глубину; но без единой законченной итерации
+            // ход всё равно нужен: лучший из досчитанных корневых, иначе первый
+            if (globalBest.bestMove.isNone()) {
+                int bestScore = -INF_SEARCH;
+                globalBest.bestMove = rootMoves[0];
+                for (size_t i = 0; i < M; ++i) {
+                    if (done[i].load() && -results[i].score > bestScore) {
+                        bestScore = -results[i].score;
+                        globalBest.bestMove = rootMoves[i];
+                        globalBest.score = bestScore;
+                    }
+                }
+            }
             break;
         }
 
@@ -189,6 +238,7 @@ SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, Transp
         globalBest.score = bestScore;
         globalBest.bestMove = bestMove;
         globalBest.depth = depth;
+        if (onIteration) onIteration(globalBest);
 
         // next depth
         ++depth;
@@ -1,6 +1,7 @@
 #ifndef SEARCHING_H
 #define SEARCHING_H
 
+#include <functional>
 #include "pvs.h"
 
 SearchResult iterativeDeepeningDepth(Position& pos, int maxDepth, TranspositionTable& tt);
@@ -8,11 +9,10 @@ SearchResult iterativeDeepeningTime(Position& pos, int maxMillis, TranspositionT
 
 inline int estimateMovesToGo(const Position& pos) {
     int material = 0;
-    for (int x = 0; x < 8; ++x) {
-        for (int y = 0; y < 8; ++y) {
-            Piece p = pos.getPiece(x, y);
-            if (p.getType() != EMPTY) material += (int)p.getType();
-        }
+    for (bool color : {true, false}) {
+        material += pos.nonPawnMaterial(color)
+                  + pos.count(PAWN, color) * PAWN
+                  + pos.count(KING, color) * KING;
     }
     return material / 60;             // эндшпиль
 }
@@ -36,7 +36,14 @@ constexpr inline int computeTimeForMove(int timeLeftMs, int incrementMs, int mov
 SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, TranspositionTable& tt);
 SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, TranspositionTable& tt);
 
-SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, TranspositionTable& tt, int numThreads);
-SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, TranspositionTable& tt, int numThreads);
+/* called with the best root move of every completed iteration */
+using IterationCallback = std::function<void(const SearchResult&)>;
+
+/* rootShare (a process' share of the root, see searchAcrossProcesses)
+   restricts the root to those of its moves that are legal */
+SearchResult iterativeDeepeningThreadsDepth(Position& pos, int maxDepth, TranspositionTable& tt, int numThreads,
+                                            const MoveList* rootShare = nullptr, const IterationCallback& onIteration = nullptr);
+SearchResult iterativeDeepeningThreadsTime(Position& pos, int timeMillis, TranspositionTable& tt, int numThreads,
+                                           const MoveList* rootShare = nullptr, const IterationCallback& onIteration = nullptr);
 
 #endif // SEARCHING_H
\ No newline at end of file
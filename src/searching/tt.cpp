@@ -1,42 +1,90 @@
 #include "pvs.h"
+#include <algorithm>
 #include <cstdint>
-#include <shared_mutex>
+#include <cstring>
+#include <fstream>
 
-// --- probe/store с улучшенным поведением и минимальной replacement-логикой ---
+// atomic_ref<const T> только с C++26 (и не в libc++): снимаем const, load ничего не пишет
+static inline uint64_t loadWord(const uint64_t& w) {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(w)).load(std::memory_order_relaxed);
+}
 
-TranspositionTable::TranspositionTable(size_t sizeMB) {
-    size_t entries = (sizeMB * 1024ULL * 1024ULL) / sizeof(TTEntry);
-    if (entries == 0) entries = 1;
-    // округлим до ближайшего степеня 2 (опционально) — но не обязательно
-    table.resize(entries);
-    // инициализируем поля явно (на всякий случай)
-    for (auto &e : table) {
-        e.key = 0;
-        e.depth = -1;
-        e.score = 0;
-        e.bound = BoundType::EXACT;
-        e.bestMove = Move{-1,-1,-1,-1, EMPTY};
-    }
+static inline void storeWord(uint64_t& w, uint64_t v) {
+    std::atomic_ref<uint64_t>(w).store(v, std::memory_order_relaxed);
+}
 
-    this->sizeMB = sizeMB;
+// data: move [0..15] | depth [16..23] | bound + 1 [24..25] | generation [26..31] | score [32..63]
+// check: ((key ^ data) & ~0xFFFF) | uint16(eval)
+// bound хранится со сдвигом на 1: у занятого слота data никогда не 0, 0 — только пустой
+
+constexpr uint64_t EVAL_MASK = 0xFFFF;
+
+static inline uint64_t makeCheck(uint64_t key, uint64_t data, int eval) {
+    return ((key ^ data) & ~EVAL_MASK) | uint16_t(int16_t(eval));
+}
+
+uint64_t TranspositionTable::pack(const TTEntry& e, uint8_t generation) {
+    return uint64_t(e.bestMove.raw())
+         | uint64_t(uint8_t(int8_t(e.depth))) << 16
+         | uint64_t(uint8_t(uint8_t(e.bound) + 1) | uint8_t(generation << 2)) << 24
+         | uint64_t(uint32_t(int32_t(e.score))) << 32;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t key, uint64_t data, uint64_t check) {
+    TTEntry e;
+    e.eval = int16_t(uint16_t(check & EVAL_MASK));
+    e.key = key;
+    e.bestMove = Move::fromRaw(uint16_t(data));
+    e.depth = int8_t(uint8_t(data >> 16));
+    e.bound = BoundType((uint8_t(data >> 24) & 3) - 1);
+    e.score = int32_t(uint32_t(data >> 32));
+    return e;
+}
+
+uint8_t TranspositionTable::generationOf(uint64_t data) {
+    return uint8_t(data >> 26) & (GENERATION_CYCLE - 1);
+}
+
+bool TranspositionTable::read(const Slot& s, uint64_t key, TTEntry& out) const {
+    uint64_t data = loadWord(s.data);
+    uint64_t check = loadWord(s.check);
+    if (((check ^ data ^ key) & ~EVAL_MASK) != 0 || data == 0) return false;
+    out = unpack(key, data, check);
+    return true;
+}
+
+TranspositionTable::TranspositionTable(size_t sizeMB) {
+    resize(sizeMB);
 }
 
 bool TranspositionTable::probe(uint64_t key, int depth, int alpha, int beta, int& score, Move& best) {
-    size_t idx = key % table.size();
-    TTEntry& e = table[idx];
+    int staticEval;
+    return probe(key, depth, alpha, beta, score, best, staticEval);
+}
+
+bool TranspositionTable::probe(uint64_t key, int depth, int alpha, int beta, int& score, Move& best, int& staticEval) {
+    Cluster& c = clusterFor(key);
 
     // default: no usable exact/alpha/beta hit
-    best = Move{-1,-1,-1,-1, EMPTY};
+    best = Move();
+    staticEval = EVAL_NONE;
 
-    if (e.key != key) return false;
+    TTEntry e;
+    bool found = false;
+    for (const Slot& s : c.slots) {
+        if (read(s, key, e)) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) return false;
 
-    // всегда отдаём stored bestMove (для ordering), даже если depth < requested
+    // всегда отдаём stored bestMove (для ordering) и оценку, даже если depth < requested
     best = e.bestMove;
+    staticEval = e.eval;
 
     // если глубина записи недостаточна — нельзя безопасно использовать оценку
     if (e.depth < depth) return false;
-    
-    std::shared_lock<std::shared_mutex> lock(tableMutex);
 
     // имеем запись с достаточной глубиной — применяем границы
     switch (e.bound) {
@@ -59,37 +107,150 @@ bool TranspositionTable::probe(uint64_t key, int depth, int alpha, int beta, int
     return false;
 }
 
-void TranspositionTable::store(uint64_t key, int depth, int score, BoundType bound, const Move& best) {
-    size_t idx = key % table.size();
-    TTEntry& e = table[idx];
-
-    std::unique_lock<std::shared_mutex> lock(tableMutex);
+void TranspositionTable::store(uint64_t key, int depth, int score, BoundType bound, const Move& best, int staticEval) {
+    Cluster& c = clusterFor(key);
 
     // Replacement policy:
-    // - если слот пустой или ключ совпадает — заменяем
-    // - если новая глубина >= старая — заменяем (предпочитаем более глубокую)
-    // - иначе оставляем старую запись
-    if (e.key == 0 || e.key == key || depth >= e.depth) {
-        e.key = key;
-        e.depth = depth;
-        e.score = score;
-        e.bound = bound;
-        e.bestMove = best;
+    // - слот с тем же ключом или пустой/битый — пишем туда
+    // - иначе вытесняем запись с наименьшим depth - 8 * age,
+    //   т.е. старые поиски уступают место даже более мелким записям
+    Slot* replace = nullptr;
+    uint64_t replaceData = 0, replaceCheck = 0;
+    int worst = 0;
+    for (Slot& s : c.slots) {
+        uint64_t data = loadWord(s.data);
+        uint64_t check = loadWord(s.check);
+        bool sameKey = ((check ^ data ^ key) & ~EVAL_MASK) == 0;
+        if (data == 0 || sameKey) {
+            replace = &s;
+            replaceData = sameKey ? data : 0;
+            replaceCheck = check;
+            break;
+        }
+        int age = (generation - generationOf(data)) & (GENERATION_CYCLE - 1);
+        int value = int8_t(uint8_t(data >> 16)) - 8 * age;
+        if (!replace || value < worst) {
+            replace = &s;
+            worst = value;
+        }
+    }
+
+    Move move = best;
+    int eval = staticEval == EVAL_NONE ? EVAL_NONE : std::clamp(staticEval, EVAL_NONE + 1, 32767);
+    if (replaceData) {
+        TTEntry old = unpack(key, replaceData, replaceCheck);
+        // та же позиция: не затираем более глубокую оценку текущего поиска
+        if (bound != BoundType::EXACT && depth < old.depth - 2 && generationOf(replaceData) == generation) return;
+        if (move.isNone()) move = old.bestMove;
+        if (eval == EVAL_NONE) eval = old.eval;
     }
-    // иначе: не перезаписываем глубже/моложе данные
+
+    uint64_t data = pack({key, depth, score, bound, move, eval}, generation);
+    storeWord(replace->data, data);
+    storeWord(replace->check, makeCheck(key, data, eval));
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & (GENERATION_CYCLE - 1);
 }
 
 void TranspositionTable::clear() {
-    size_t entries = (this->sizeMB * 1024ULL * 1024ULL) / sizeof(TTEntry);
-    if (entries == 0) entries = 1;
-    // округлим до ближайшего степеня 2 (опционально) — но не обязательно
-    table.resize(entries);
-    // инициализируем поля явно (на всякий случай)
-    for (auto &e : table) {
-        e.key = 0;
-        e.depth = -1;
-        e.score = 0;
-        e.bound = BoundType::EXACT;
-        e.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    // своя память — без прохода по таблице (ядро отдаёт нули при первом касании),
+    // только общий сегмент SharedHash чистится memset'ом по потокам
+    memory.zero();
+    table = static_cast<Cluster*>(memory.data());
+    generation = 0;
+}
+
+void TranspositionTable::resize(size_t sizeMB) {
+    size_t clusters = (sizeMB * 1024ULL * 1024ULL) / sizeof(Cluster);
+    if (clusters == 0) clusters = 1;
+
+    memory = TTMemory();  // старое отображение отпускаем до выделения нового
+    memory = TTMemory::anonymous(clusters * sizeof(Cluster));
+    table = static_cast<Cluster*>(memory.data());
+    clusterCount = clusters;
+    this->sizeMB = sizeMB;
+    generation = 0;
+}
+
+bool TranspositionTable::attachShared(const std::string& name) {
+    TTMemory shm = TTMemory::shared(name, sizeMB * 1024ULL * 1024ULL);
+    if (!shm.data() || shm.size() < sizeof(Cluster)) return false;
+
+    memory = std::move(shm);
+    table = static_cast<Cluster*>(memory.data());
+    clusterCount = memory.size() / sizeof(Cluster);
+    sizeMB = memory.size() / (1024 * 1024);
+    return true;
+}
+
+// --- снимки таблицы в файл ---
+
+/* bump whenever Slot, Cluster or the data/check word layout changes */
+constexpr uint32_t TT_FILE_VERSION = 3;
+/* clusters start on a page boundary so the file can be mapped as is */
+constexpr size_t TT_FILE_HEADER_BYTES = 4096;
+
+struct TTFileHeader {
+    char magic[8];             // "SHINYTT"
+    uint32_t version;
+    uint32_t clusterBytes;
+    uint32_t slotsPerCluster;
+    uint32_t slotBytes;
+    uint64_t zobristSeed;
+    uint64_t clusterCount;
+    uint32_t generation;
+};
+static_assert(sizeof(TTFileHeader) <= TT_FILE_HEADER_BYTES);
+
+static constexpr char TT_FILE_MAGIC[8] = "SHINYTT";
+
+bool TranspositionTable::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    char page[TT_FILE_HEADER_BYTES] = {};
+    TTFileHeader h{};
+    std::memcpy(h.magic, TT_FILE_MAGIC, sizeof(h.magic));
+    h.version = TT_FILE_VERSION;
+    h.clusterBytes = sizeof(Cluster);
+    h.slotsPerCluster = CLUSTER_SIZE;
+    h.slotBytes = sizeof(Slot);
+    h.zobristSeed = ZOBRIST_SEED;
+    h.clusterCount = clusterCount;
+    h.generation = generation;
+    std::memcpy(page, &h, sizeof(h));
+
+    out.write(page, sizeof(page));
+    out.write(reinterpret_cast<const char*>(table), std::streamsize(clusterCount * sizeof(Cluster)));
+    return bool(out);
+}
+
+bool TranspositionTable::load(const std::string& path) {
+    TTFileHeader h{};
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+    }
+    if (std::memcmp(h.magic, TT_FILE_MAGIC, sizeof(h.magic)) != 0
+        || h.version != TT_FILE_VERSION
+        || h.clusterBytes != sizeof(Cluster)
+        || h.slotsPerCluster != CLUSTER_SIZE
+        || h.slotBytes != sizeof(Slot)
+        || h.zobristSeed != ZOBRIST_SEED
+        || h.clusterCount == 0) {
+        return false;
     }
-}
\ No newline at end of file
+
+    // данные не читаются: страницы подтягиваются при первом обращении
+    TTMemory mapped = TTMemory::mapFile(path, TT_FILE_HEADER_BYTES);
+    if (!mapped.data() || mapped.size() < h.clusterCount * sizeof(Cluster)) return false;
+
+    memory = std::move(mapped);
+    table = static_cast<Cluster*>(memory.data());
+    clusterCount = h.clusterCount;
+    sizeMB = clusterCount * sizeof(Cluster) / (1024 * 1024);
+    generation = uint8_t(h.generation) & (GENERATION_CYCLE - 1);
+    return true;
+}
@@ -0,0 +1,182 @@
+#include "tt_memory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// граница huge page на Linux/x86-64 и arm64
+static constexpr size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+static size_t roundUp(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+TTMemory::~TTMemory() {
+    release();
+}
+
+TTMemory::TTMemory(TTMemory&& other) noexcept {
+    *this = std::move(other);
+}
+
+TTMemory& TTMemory::operator=(TTMemory&& other) noexcept {
+    if (this != &other) {
+        release();
+        ptr = other.ptr;
+        bytes = other.bytes;
+        mapBase = other.mapBase;
+        mapBytes = other.mapBytes;
+        type = other.type;
+        shmName = std::move(other.shmName);
+        other.shmName.clear();
+        other.ptr = other.mapBase = nullptr;
+        other.bytes = other.mapBytes = 0;
+        other.type = Kind::NONE;
+    }
+    return *this;
+}
+
+void TTMemory::release() {
+    if (mapBase) munmap(mapBase, mapBytes);
+    if (!shmName.empty()) shm_unlink(shmName.c_str());
+    shmName.clear();
+    ptr = mapBase = nullptr;
+    bytes = mapBytes = 0;
+    type = Kind::NONE;
+}
+
+TTMemory TTMemory::anonymous(size_t bytes) {
+    TTMemory m;
+    size_t size = roundUp(std::max<size_t>(bytes, 1), HUGE_PAGE);
+
+#ifdef MAP_HUGETLB
+    // зарезервированные huge pages (vm.nr_hugepages), чаще всего их нет
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        m.ptr = m.mapBase = p;
+        m.bytes = m.mapBytes = size;
+        m.type = Kind::ANONYMOUS;
+        return m;
+    }
+#endif
+
+    // лишние 2 MB, чтобы выровнять начало под transparent huge pages
+    size_t mapped = size + HUGE_PAGE;
+    void* base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) throw std::bad_alloc();
+
+    uintptr_t start = roundUp(uintptr_t(base), HUGE_PAGE);
+    size_t head = start - uintptr_t(base);
+    if (head) munmap(base, head);
+    size_t tail = mapped - head - size;
+    if (tail) munmap((char*)start + size, tail);
+
+    m.ptr = m.mapBase = (void*)start;
+    m.bytes = m.mapBytes = size;
+    m.type = Kind::ANONYMOUS;
+#ifdef MADV_HUGEPAGE
+    madvise(m.ptr, size, MADV_HUGEPAGE);
+#endif
+    return m;
+}
+
+TTMemory TTMemory::mapFile(const std::string& path, size_t offset) {
+    TTMemory m;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return m;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) <= offset) {
+        close(fd);
+        return m;
+    }
+
+    size_t size = size_t(st.st_size);
+    // MAP_PRIVATE: поиск пишет в свои копии страниц, файл не меняется
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return m;
+
+    m.mapBase = base;
+    m.mapBytes = size;
+    m.ptr = (char*)base + offset;
+    m.bytes = size - offset;
+    m.type = Kind::FILE;
+    return m;
+}
+
+TTMemory TTMemory::shared(const std::string& name, size_t bytes) {
+    TTMemory m;
+    bool created = true;
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) return m;
+
+    size_t size = roundUp(std::max<size_t>(bytes, 1), HUGE_PAGE);
+    struct stat st;
+    if (!created && fstat(fd, &st) == 0 && st.st_size > 0) {
+        // сегмент уже создан другим процессом: берём его размер
+        size = size_t(st.st_size);
+    } else if (ftruncate(fd, off_t(size)) != 0) {
+        close(fd);
+        if (created) shm_unlink(name.c_str());
+        return m;
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        if (created) shm_unlink(name.c_str());
+        return m;
+    }
+
+    m.ptr = m.mapBase = base;
+    m.bytes = m.mapBytes = size;
+    m.type = Kind::SHARED;
+    if (created) m.shmName = name;
+    return m;
+}
+
+void TTMemory::zero() {
+    if (!ptr) return;
+    if (type == Kind::ANONYMOUS) {
+#ifdef __linux__
+        // приватные анонимные страницы после DONTNEED читаются как нули
+        if (madvise(mapBase, mapBytes, MADV_DONTNEED) == 0) return;
+#endif
+    }
+    if (type == Kind::ANONYMOUS || type == Kind::FILE) {
+        // DONTNEED не обнуляет (не Linux) или страницы файловые: берём новое отображение
+        *this = anonymous(bytes);
+        return;
+    }
+    parallelZero(ptr, bytes);
+}
+
+void parallelZero(void* ptr, size_t bytes) {
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    // мелкие куски не стоят запуска потока
+    threads = std::min(threads, std::max<size_t>(1, bytes / HUGE_PAGE));
+    size_t chunk = roundUp((bytes + threads - 1) / threads, 64);
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        size_t begin = i * chunk;
+        if (begin >= bytes) break;
+        size_t len = std::min(chunk, bytes - begin);
+        workers.emplace_back([=] { std::memset((char*)ptr + begin, 0, len); });
+    }
+    std::memset(ptr, 0, std::min(chunk, bytes));
+    for (auto& t : workers) t.join();
+}
@@ -0,0 +1,62 @@
+#ifndef TT_MEMORY_H
+#define TT_MEMORY_H
+
+#include <cstddef>
+#include <string>
+
+/* Owner of the big mapping behind the transposition table. Fresh
+   anonymous mappings come zero-filled from the kernel, so allocating a
+   table costs nothing until its pages are first touched. File mappings
+   are private, so search writes never reach the file. Shared mappings
+   are named POSIX segments that several engine processes map at once. */
+class TTMemory {
+public:
+    enum class Kind { NONE, ANONYMOUS, FILE, SHARED };
+
+    TTMemory() = default;
+    ~TTMemory();
+    TTMemory(TTMemory&& other) noexcept;
+    TTMemory& operator=(TTMemory&& other) noexcept;
+    TTMemory(const TTMemory&) = delete;
+    TTMemory& operator=(const TTMemory&) = delete;
+
+    /* private zero-filled mapping, 2 MB aligned and backed by huge pages
+       where the OS allows it; falls back to plain pages otherwise */
+    static TTMemory anonymous(size_t bytes);
+    /* copy-on-write mapping of a whole file, data() starts `offset` bytes
+       in; pages are read on first touch. Empty (data() == nullptr) if the
+       file cannot be mapped or is not longer than offset */
+    static TTMemory mapFile(const std::string& path, size_t offset);
+    /* shm_open(name) + MAP_SHARED. The first process creates the segment
+       with `bytes` (zero-filled) and unlinks it when it lets go; later ones
+       map it at whatever size it already has. Empty on failure */
+    static TTMemory shared(const std::string& name, size_t bytes);
+
+    /* makes every byte zero again without touching the pages: anonymous
+       memory relies on MADV_DONTNEED (Linux hands the pages back zeroed on
+       next touch) and is remapped where that is not available, a private
+       file mapping is swapped for anonymous memory. Only shared segments,
+       which other processes keep mapped, are cleared by parallelZero() */
+    void zero();
+
+    inline void* data() const { return ptr; }
+    inline size_t size() const { return bytes; }
+    inline Kind kind() const { return type; }
+
+private:
+    void release();
+
+    void* ptr = nullptr;
+    size_t bytes = 0;
+    /* what was actually mapped, ptr may sit inside it after alignment */
+    void* mapBase = nullptr;
+    size_t mapBytes = 0;
+    Kind type = Kind::NONE;
+    /* shared segments only: name to shm_unlink, set in the creating process */
+    std::string shmName;
+};
+
+/* memset split across hardware threads, for shared segments that cannot simply be remapped */
+void parallelZero(void* ptr, size_t bytes);
+
+#endif // TT_MEMORY_H
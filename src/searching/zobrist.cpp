@@ -1,4 +1,5 @@
-#include "pvs.h"
+#include "zobrist.h"
+#include "../position/position.h"
 
 #include <random>
 
@@ -6,9 +7,10 @@ uint64_t zobristTable[2][6][8][8];
 uint64_t zobristSide;
 uint64_t zobristCastle[16];
 uint64_t zobristEnPassant[8];
+uint64_t zobristMaterial[2][6][16];
 
 void initZobrist() {
-    std::mt19937_64 rng(2025); // фиксированный сид для стабильности
+    std::mt19937_64 rng(ZOBRIST_SEED); // фиксированный сид для стабильности
     std::uniform_int_distribution<uint64_t> dist;
 
     for (int c=0;c<2;++c)
@@ -20,6 +22,12 @@ void initZobrist() {
     zobristSide = dist(rng);
     for (int i=0;i<16;++i) zobristCastle[i] = dist(rng);
     for (int f=0;f<8;++f) zobristEnPassant[f] = dist(rng);
+
+    // тянем последними, чтобы остальные ключи не изменились
+    for (int c=0;c<2;++c)
+        for (int p=0;p<6;++p)
+            for (int n=0;n<16;++n)
+                zobristMaterial[c][p][n] = dist(rng);
 }
 
 uint64_t computeHash(const Position& pos) {
@@ -54,3 +62,21 @@ uint64_t computeHash(const Position& pos) {
 
     return h;
 }
+
+uint64_t computeMaterialKey(const Position& pos) {
+    uint64_t h = 0;
+    for (bool color : {true, false})
+        for (int p=0; p<6; ++p)
+            for (int n=0; n<pos.count(pieceByIndex[p], color); ++n)
+                h ^= zobristMaterialCount(color, p, n);
+    return h;
+}
+
+uint64_t computePawnKey(const Position& pos) {
+    uint64_t h = 0;
+    for (bool color : {true, false}) {
+        Bitboard b = pos.pieces(PAWN, color);
+        while (b) h ^= zobristPiece(color, PAWN_IDX, popLsb(b));
+    }
+    return h;
+}
@@ -0,0 +1,37 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include "../bitboard/bitboard.h"
+
+class Position;
+
+// zobrist keys
+extern uint64_t zobristTable[2][6][8][8]; // [color][pieceType][file][rank]
+extern uint64_t zobristSide;              // чей ход
+extern uint64_t zobristCastle[16];        // рокировочные права
+extern uint64_t zobristEnPassant[8];      // файл взятия на проходе
+extern uint64_t zobristMaterial[2][6][16]; // [color][pieceType][count], только для materialKey
+
+/* seed of initZobrist(), saved hash files are only valid for the same keys */
+constexpr uint64_t ZOBRIST_SEED = 2025;
+
+void initZobrist();
+/* full recomputation, Position keeps its key incrementally */
+uint64_t computeHash(const Position& pos);
+/* XOR of zobristMaterial[c][t][0..n-1] over all piece counts */
+uint64_t computeMaterialKey(const Position& pos);
+/* piece keys of the pawns only */
+uint64_t computePawnKey(const Position& pos);
+
+/* color: true = white, index as in pieceIndex() */
+inline uint64_t zobristPiece(bool color, int index, int sq) {
+    return zobristTable[color ? 0 : 1][index][fileOf(sq)][rankOf(sq)];
+}
+
+/* key for the count-th piece (0-based) of this type and colour */
+inline uint64_t zobristMaterialCount(bool color, int index, int count) {
+    return zobristMaterial[color ? 0 : 1][index][count & 15];
+}
+
+#endif // ZOBRIST_H
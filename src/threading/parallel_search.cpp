@@ -37,13 +37,13 @@ SearchResult ParallelSearch::searchChildTask(Position child, int depth, int alph
 // Core: parallelized node processing (YBWC-style but using a threadpool).
 SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int alpha, int beta, TranspositionTable& tt, const ParallelOptions& opts) {
     SearchResult result{};
-    result.bestMove = Move{-1,-1,-1,-1, EMPTY};
-    uint64_t key = computeHash(pos);
+    result.bestMove = Move();
+    uint64_t key = pos.getHash();
     int alphaOrig = alpha;
 
     // quick TT probe
     int ttScore = 0;
-    Move ttMove{-1,-1,-1,-1, EMPTY};
+    Move ttMove = Move();
     if (tt.probe(key, depth, alpha, beta, ttScore, ttMove)) {
         result.score = ttScore;
         result.bestMove = ttMove;
@@ -51,11 +51,11 @@ SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int al
     }
 
     if (depth <= 0) {
-        result.score = quiescence(pos, alpha, beta);
+        result.score = quiescence(pos, alpha, beta, tt);
         return result;
     }
 
-    std::vector<Move> moves = pos.getLegalMoves();
+    MoveList moves = pos.getLegalMoves();
     if (moves.empty()) {
         if (pos.isCheck()) result.score = -1000000000 + depth;
         else result.score = 0;
@@ -67,17 +67,17 @@ SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int al
     }
 
     // ordering: try TT move first
-    if (ttMove.fromX != -1) {
-        auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m){
-            return m.fromX==ttMove.fromX && m.fromY==ttMove.fromY && m.toX==ttMove.toX && m.toY==ttMove.toY && m.promotion==ttMove.promotion;
-        });
+    if (!ttMove.isNone()) {
+        auto it = std::find(moves.begin(), moves.end(), ttMove);
         if (it != moves.end()) std::iter_swap(moves.begin(), it);
     }
 
     // First move in this thread (full window)
     Move bestMove = moves[0];
-    Position firstChild = pos; firstChild.applyMove(bestMove);
-    SearchResult firstRes = pvs(firstChild, depth-1, -beta, -alpha, false, tt);
+    UndoInfo firstUndo;
+    pos.makeMove(bestMove, firstUndo);
+    SearchResult firstRes = pvs(pos, depth-1, -beta, -alpha, false, tt);
+    pos.unmakeMove(bestMove, firstUndo);
     int bestScore = -firstRes.score;
     if (bestScore > alpha) alpha = bestScore;
     if (alpha >= beta) {
@@ -99,13 +99,14 @@ SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int al
     // Submit tasks for moves[1..]
     for (size_t i = 0; i < nTasks; ++i) {
         Move mv = moves[i+1];
-        Position childPos = pos; childPos.applyMove(mv);
+        Position childPos = pos.afterMove(mv);
         // snapshot alpha for narrow-window
         int snapAlpha = alpha;
 
         // Capture by value what we need. tt pointer for shared TT
         TranspositionTable* ttp = &tt;
-        pool->enqueue([i, childPos = std::move(childPos), depth, snapAlpha, ttp, &results, &finished, &remaining, &resMutex, &resCv, mv]() mutable {
+        // Position is trivially copyable (<= 128 bytes), capturing by value is a plain memcpy
+        pool->enqueue([i, childPos, depth, snapAlpha, ttp, &results, &finished, &remaining, &resCv]() mutable {
             if (search_control::shouldStop()) {
                 // leave finished false; main thread will break eventually
                 remaining.fetch_sub(1);
@@ -113,7 +114,7 @@ SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int al
                 return;
             }
             // narrow-window search
-            SearchResult r = pvs(const_cast<Position&>(childPos), depth-1, -snapAlpha-1, -snapAlpha, false, *ttp);
+            SearchResult r = pvs(childPos, depth-1, -snapAlpha-1, -snapAlpha, false, *ttp);
 
             // store result
             results[i] = r;
@@ -141,8 +142,10 @@ SearchResult ParallelSearch::searchNodeParallel(Position& pos, int depth, int al
 
             if (val > bestScore) {
                 // re-search in main thread with full window to get exact score
-                Position child = pos; child.applyMove(mv);
-                SearchResult full = pvs(child, depth-1, -beta, -alpha, false, tt);
+                UndoInfo undo;
+                pos.makeMove(mv, undo);
+                SearchResult full = pvs(pos, depth-1, -beta, -alpha, false, tt);
+                pos.unmakeMove(mv, undo);
                 val = -full.score;
                 if (val > bestScore) {
                     bestScore = val;
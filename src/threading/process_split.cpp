@@ -0,0 +1,117 @@
+#include "process_split.h"
+
+#include <algorithm>
+#include <iostream>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// лучший ход каждой законченной итерации процесса, в общей (MAP_SHARED) памяти
+constexpr int MAX_ITERATIONS = 128;
+
+struct alignas(64) ProcessResult {
+    struct Iteration {
+        int32_t score;
+        uint16_t move;
+    };
+    Iteration byDepth[MAX_ITERATIONS + 1];
+    int32_t depth;       // последняя законченная итерация, 0 — ни одной
+    // итог search(): без законченных итераций это запасной ход
+    int32_t finalScore;
+    uint16_t finalMove;
+};
+
+MoveList shareOf(const MoveList& all, int k, int n) {
+    MoveList res;
+    for (int i = k; i < all.size(); i += n) res.push_back(all[i]);
+    return res;
+}
+
+void runShare(ProcessResult& out,
+              const std::function<SearchResult(const MoveList&, const IterationCallback&)>& search,
+              const MoveList& share) {
+    SearchResult r = search(share, [&out](const SearchResult& it) {
+        if (it.depth < 1 || it.depth > MAX_ITERATIONS || it.bestMove.isNone()) return;
+        out.byDepth[it.depth] = {int32_t(it.score), it.bestMove.raw()};
+        out.depth = it.depth;
+    });
+    out.finalScore = r.score;
+    out.finalMove = r.bestMove.raw();
+}
+
+} // namespace
+
+SearchResult searchAcrossProcesses(const Position& pos, int processes,
+                                   const std::function<SearchResult(const MoveList&, const IterationCallback&)>& search) {
+    MoveList all = pos.getLegalMoves();
+    int n = std::min(processes, all.size());
+    if (n <= 1) return search(all, nullptr);
+
+    void* mem = mmap(nullptr, sizeof(ProcessResult) * n, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return search(all, nullptr);
+    ProcessResult* results = new (mem) ProcessResult[n]();
+
+    // иначе буфер вывода окажется в каждом потомке
+    std::cout.flush();
+
+    std::vector<pid_t> children;
+    MoveList own = shareOf(all, 0, n);
+    for (int k = 1; k < n; ++k) {
+        MoveList share = shareOf(all, k, n);
+        pid_t pid = fork();
+        if (pid == 0) {
+            runShare(results[k], search, share);
+            _exit(0);
+        }
+        if (pid > 0) {
+            children.push_back(pid);
+        } else {
+            // fork не удался: эту долю ищем сами
+            for (const Move& m : share) own.push_back(m);
+        }
+    }
+
+    runShare(results[0], search, own);
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+
+    // по времени процессы доходят до разных глубин, а оценки разных глубин
+    // несравнимы: лишняя итерация у доли с плохими ходами не должна побеждать.
+    // Сравниваем на самой глубокой итерации, законченной всеми процессами
+    int common = MAX_ITERATIONS;
+    for (int k = 0; k < n; ++k) {
+        if (results[k].depth > 0) common = std::min(common, int(results[k].depth));
+    }
+
+    SearchResult best{};
+    best.score = -1000000000;
+    best.bestMove = Move();
+    for (int k = 0; k < n; ++k) {
+        const ProcessResult& r = results[k];
+        if (r.depth == 0) continue;
+        const ProcessResult::Iteration& it = r.byDepth[common];
+        if (best.bestMove.isNone() || it.score > best.score) {
+            best.score = it.score;
+            best.depth = common;
+            best.bestMove = Move::fromRaw(it.move);
+        }
+    }
+
+    // ни один процесс не закончил и первой итерации: лучший из запасных ходов
+    if (best.bestMove.isNone()) {
+        for (int k = 0; k < n; ++k) {
+            const ProcessResult& r = results[k];
+            if (Move::fromRaw(r.finalMove).isNone()) continue;
+            if (best.bestMove.isNone() || r.finalScore > best.score) {
+                best.score = r.finalScore;
+                best.bestMove = Move::fromRaw(r.finalMove);
+            }
+        }
+    }
+    munmap(mem, sizeof(ProcessResult) * n);
+    return best;
+}
@@ -0,0 +1,17 @@
+#ifndef PROCESS_SPLIT_H
+#define PROCESS_SPLIT_H
+
+#include <functional>
+#include "searching/searching.h"
+
+/* Local coordinator: root moves are dealt round-robin to `processes`
+   forked copies of the engine, each searching its share through
+   search(moves, onIteration) and publishing every completed iteration.
+   On a SharedHash table all processes read and write one TT. The winner
+   is the best score at the deepest iteration every process completed,
+   since scores of different depths do not compare; with fewer than two
+   moves, search() of the whole root. */
+SearchResult searchAcrossProcesses(const Position& pos, int processes,
+                                   const std::function<SearchResult(const MoveList&, const IterationCallback&)>& search);
+
+#endif // PROCESS_SPLIT_H
@@ -6,22 +6,19 @@
 #include <chrono>
 #include "search_control.h"
 #include "evaluation/evaluation.h"
-
-constexpr inline int pieceValue(Figures figure) {
-    return figure;
-}
+#include "searching/movepick.h"
 
 // Удобные константы
 static constexpr int INF = 1000000000;
 static constexpr int MATE = 100000;
 
 // Forward: внутренняя quiescence (negamax-конвенция — score с точки зрения стороны на ходу)
-static int quiescence_local(Position& pos, int alpha, int beta);
+static int quiescence_local(Position& pos, int alpha, int beta, TranspositionTable& tt);
 
 // ---------------------- Sequential PVS (negamax-style) ----------------------
 SearchResult pvs_seq(Position& pos, int depth, int alpha, int beta, TranspositionTable& tt) {
     SearchResult res{};
-    res.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    res.bestMove = Move();
     res.depth = depth;
 
     if (search_control::shouldStop()) {
@@ -29,12 +26,18 @@ SearchResult pvs_seq(Position& pos, int depth, int alpha, int beta, Transpositio
         return res;
     }
 
-    uint64_t key = computeHash(pos);
+    // ничья по материалу: искать дальше нечего
+    if (pos.isInsufficientMaterial()) {
+        res.score = 0;
+        return res;
+    }
+
+    uint64_t key = pos.getHash();
     int alphaOrig = alpha;
 
     // TT probe
     int ttScore = 0;
-    Move ttMove{-1,-1,-1,-1, EMPTY};
+    Move ttMove = Move();
     if (tt.probe(key, depth, alpha, beta, ttScore, ttMove)) {
         res.score = ttScore;
         res.bestMove = ttMove;
@@ -42,65 +45,58 @@ SearchResult pvs_seq(Position& pos, int depth, int alpha, int beta, Transpositio
     }
 
     if (depth <= 0) {
-        res.score = quiescence_local(pos, alpha, beta);
-        return res;
-    }
-
-    std::vector<Move> moves = pos.getLegalMoves();
-    if (moves.empty()) {
-        if (pos.isCheck()) res.score = -MATE + depth;
-        else res.score = 0;
+        res.score = quiescence_local(pos, alpha, beta, tt);
         return res;
     }
 
-    // ordering: ttMove first
-    if (ttMove.fromX != -1) {
-        auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m){
-            return m.fromX==ttMove.fromX && m.fromY==ttMove.fromY &&
-                   m.toX==ttMove.toX && m.toY==ttMove.toY && m.promotion==ttMove.promotion;
-        });
-        if (it != moves.end()) std::iter_swap(moves.begin(), it);
-    }
-
-    // simple MVV/LVA-like sort for remaining
-    std::stable_sort(moves.begin()+1, moves.end(), [&](const Move& a, const Move& b){
-        Piece ta = pos.getPiece(a.toX, a.toY);
-        Piece tb = pos.getPiece(b.toX, b.toY);
-        int va = (ta.getType()==EMPTY && !a.isEnPassant) ? 0 : pieceValue(ta.getType());
-        int vb = (tb.getType()==EMPTY && !b.isEnPassant) ? 0 : pieceValue(tb.getType());
-        return va > vb;
-    });
+    // staged ordering: ttMove first, then captures, killers, then quiets
+    MovePicker picker(pos, ttMove, depth);
 
     int bestScore = -INF;
-    Move bestMove = Move{-1,-1,-1,-1, EMPTY};
+    Move bestMove = Move();
     bool first = true;
+    int moveCount = 0;
 
-    for (const Move& m : moves) {
+    Move m;
+    while (!(m = picker.next()).isNone()) {
         if (search_control::shouldStop()) break;
+        ++moveCount;
 
-        Position child = pos;
-        child.applyMove(m);
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        // ключ ребёнка уже готов: кластер грузится, пока идём до probe
+        tt.prefetch(pos.getHash());
 
         int val;
         if (first) {
-            SearchResult sr = pvs_seq(child, depth-1, -beta, -alpha, tt);
+            SearchResult sr = pvs_seq(pos, depth-1, -beta, -alpha, tt);
             val = -sr.score;
             first = false;
         } else {
-            SearchResult sr = pvs_seq(child, depth-1, -alpha-1, -alpha, tt);
+            SearchResult sr = pvs_seq(pos, depth-1, -alpha-1, -alpha, tt);
             val = -sr.score;
             if (val > alpha && val < beta) {
-                SearchResult sr2 = pvs_seq(child, depth-1, -beta, -alpha, tt);
+                SearchResult sr2 = pvs_seq(pos, depth-1, -beta, -alpha, tt);
                 val = -sr2.score;
             }
         }
+        pos.unmakeMove(m, undo);
 
         if (val > bestScore) {
             bestScore = val;
             bestMove = m;
         }
         if (bestScore > alpha) alpha = bestScore;
-        if (alpha >= beta) break;
+        if (alpha >= beta) {
+            recordCutoff(pos, m, depth); // killers and history, quiet moves only
+            break;
+        }
+    }
+
+    if (moveCount == 0 && !search_control::shouldStop()) {
+        if (pos.isCheck()) res.score = -MATE + depth;
+        else res.score = 0;
+        return res;
     }
 
     res.score = bestScore;
@@ -115,38 +111,51 @@ SearchResult pvs_seq(Position& pos, int depth, int alpha, int beta, Transpositio
 }
 
 // ---------------------- Local quiescence ----------------------
-static int quiescence_local(Position& pos, int alpha, int beta) {
+static int quiescence_local(Position& pos, int alpha, int beta, TranspositionTable& tt) {
     if (search_control::shouldStop()) return 0;
-    int stand = evaluate(pos); // предполагаем, что evaluate уже в negamax-конвенции (side to move)
-    // Если evaluate возвращает с точки зрения белых, распакуйте/инвертируйте заранее.
-    if (stand >= beta) return beta;
-    if (stand > alpha) alpha = stand;
-
-    std::vector<Move> moves = pos.getLegalMoves();
-    bool inCheck = pos.isCheck();
-
-    // sort captures first
-    std::stable_sort(moves.begin(), moves.end(), [&](const Move& a, const Move& b){
-        Piece ta = pos.getPiece(a.toX, a.toY);
-        Piece tb = pos.getPiece(b.toX, b.toY);
-        int va = (ta.getType()==EMPTY && !a.isEnPassant) ? 0 : pieceValue(ta.getType());
-        int vb = (tb.getType()==EMPTY && !b.isEnPassant) ? 0 : pieceValue(tb.getType());
-        return va > vb;
-    });
-
-    for (const Move& m : moves) {
-        if (search_control::shouldStop()) break;
+    uint64_t key = pos.getHash();
+    int alphaOrig = alpha;
 
-        Piece tgt = pos.getPiece(m.toX, m.toY);
-        bool isCap = (tgt.getType() != EMPTY) || m.isEnPassant;
-        if (!inCheck && !isCap) continue;
+    // TT на глубине 0: отсечение или хотя бы сохранённая статическая оценка
+    int ttScore = 0, staticEval = EVAL_NONE;
+    Move ttMove = Move();
+    if (tt.probe(key, 0, alpha, beta, ttScore, ttMove, staticEval)) return ttScore;
+
+    // далеко за окном хватает материала + PST; такая оценка не точная и в TT не идёт
+    int stand = staticEval;
+    if (stand == EVAL_NONE) {
+        bool lazy;
+        stand = evaluate(pos, alpha, beta, lazy);
+        if (!lazy) staticEval = stand;
+    }
+    if (stand >= beta) {
+        tt.store(key, 0, beta, BoundType::LOWER, Move(), staticEval);
+        return beta;
+    }
+    if (stand > alpha) alpha = stand;
 
-        Position child = pos;
-        child.applyMove(m);
-        int score = -quiescence_local(child, -beta, -alpha);
-        if (score >= beta) return beta;
-        if (score > alpha) alpha = score;
+    // captures only (evasions in check), best victim first
+    MovePicker picker(pos);
+    Move bestMove = Move();
+    Move m;
+    while (!(m = picker.next()).isNone()) {
+        if (search_control::shouldStop()) return alpha; // неполный результат в TT не пишем
+
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        tt.prefetch(pos.getHash());
+        int score = -quiescence_local(pos, -beta, -alpha, tt);
+        pos.unmakeMove(m, undo);
+        if (score >= beta) {
+            tt.store(key, 0, beta, BoundType::LOWER, m, staticEval);
+            return beta;
+        }
+        if (score > alpha) {
+            alpha = score;
+            bestMove = m;
+        }
     }
+    tt.store(key, 0, alpha, alpha > alphaOrig ? BoundType::EXACT : BoundType::UPPER, bestMove, staticEval);
     return alpha;
 }
 
@@ -154,7 +163,7 @@ static int quiescence_local(Position& pos, int alpha, int beta) {
 SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
                          TranspositionTable& tt, ThreadPool& pool, const PvsMtOptions& opts) {
     SearchResult result{};
-    result.bestMove = Move{-1,-1,-1,-1, EMPTY};
+    result.bestMove = Move();
     result.depth = depth;
 
     if (search_control::shouldStop()) {
@@ -162,12 +171,12 @@ SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
         return result;
     }
 
-    uint64_t key = computeHash(pos);
+    uint64_t key = pos.getHash();
     int alphaOrig = alpha;
 
     // TT probe
     int ttScore = 0;
-    Move ttMove{-1,-1,-1,-1, EMPTY};
+    Move ttMove = Move();
     if (tt.probe(key, depth, alpha, beta, ttScore, ttMove)) {
         result.score = ttScore;
         result.bestMove = ttMove;
@@ -175,11 +184,11 @@ SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
     }
 
     if (depth <= 0) {
-        result.score = quiescence_local(pos, alpha, beta);
+        result.score = quiescence_local(pos, alpha, beta, tt);
         return result;
     }
 
-    std::vector<Move> moves = pos.getLegalMoves();
+    MoveList moves = pos.getLegalMoves();
     if (moves.empty()) {
         if (pos.isCheck()) result.score = -MATE + depth;
         else result.score = 0;
@@ -193,18 +202,17 @@ SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
     }
 
     // order: ttMove first
-    if (ttMove.fromX != -1) {
-        auto it = std::find_if(moves.begin(), moves.end(), [&](const Move& m){
-            return m.fromX==ttMove.fromX && m.fromY==ttMove.fromY &&
-                   m.toX==ttMove.toX && m.toY==ttMove.toY && m.promotion==ttMove.promotion;
-        });
+    if (!ttMove.isNone()) {
+        auto it = std::find(moves.begin(), moves.end(), ttMove);
         if (it != moves.end()) std::iter_swap(moves.begin(), it);
     }
 
     // first move search in current thread (full window)
     Move bestMove = moves[0];
-    Position child0 = pos; child0.applyMove(bestMove);
-    SearchResult r0 = pvs_seq(child0, depth-1, -beta, -alpha, tt);
+    UndoInfo undo0;
+    pos.makeMove(bestMove, undo0);
+    SearchResult r0 = pvs_seq(pos, depth-1, -beta, -alpha, tt);
+    pos.unmakeMove(bestMove, undo0);
     int bestScore = -r0.score;
     if (bestScore > alpha) alpha = bestScore;
     if (alpha >= beta) {
@@ -226,18 +234,18 @@ SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
     // submit tasks for moves[1..]
     for (size_t i = 0; i < nTasks; ++i) {
         Move mv = moves[i+1];
-        Position child = pos; child.applyMove(mv);
+        Position child = pos.afterMove(mv);
         int snapAlpha = alpha;
         TranspositionTable* ttp = &tt;
-        // capture child by move to avoid copy
-        pool.enqueue([i, child = std::move(child), depth, snapAlpha, ttp, &results, &ready, &remaining, &cv]() mutable {
+        // Position is trivially copyable (<= 128 bytes), capturing by value is a plain memcpy
+        pool.enqueue([i, child, depth, snapAlpha, ttp, &results, &ready, &remaining, &cv]() mutable {
             if (search_control::shouldStop()) {
                 remaining.fetch_sub(1);
                 cv.notify_one();
                 return;
             }
             // narrow-window search
-            SearchResult sr = pvs_seq(const_cast<Position&>(child), depth-1, -snapAlpha-1, -snapAlpha, *ttp);
+            SearchResult sr = pvs_seq(child, depth-1, -snapAlpha-1, -snapAlpha, *ttp);
             results[i] = sr;
             ready[i].store(true);
             remaining.fetch_sub(1);
@@ -265,8 +273,10 @@ SearchResult pvs_mt_root(Position& pos, int depth, int alpha, int beta,
 
             if (val > bestScore) {
                 // re-search in main thread with full window
-                Position child = pos; child.applyMove(mv);
-                SearchResult full = pvs_seq(child, depth-1, -beta, -alpha, tt);
+                UndoInfo undo;
+                pos.makeMove(mv, undo);
+                SearchResult full = pvs_seq(pos, depth-1, -beta, -alpha, tt);
+                pos.unmakeMove(mv, undo);
                 val = -full.score;
                 if (val > bestScore) {
                     bestScore = val;
@@ -1,6 +1,8 @@
 #pragma once
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <limits>
 
 namespace search_control {
 
@@ -14,6 +16,12 @@ inline void setDeadlineMillis(int64_t millis) {
     stopSearch.store(false);
 }
 
+// Поиск без лимита по времени (go depth): дедлайн далеко в будущем,
+// иначе shouldStop() сработает по дедлайну прошлого поиска
+inline void clearDeadline() {
+    setDeadlineMillis(std::numeric_limits<int32_t>::max());
+}
+
 // Проверить пора ли остановиться
 inline bool shouldStop() {
     if (stopSearch.load(std::memory_order_relaxed)) return true;